@@ -0,0 +1,113 @@
+#include "abpage.h"
+#include "crc32.h"
+
+#define ABPAGE_MAGIC 0x41425047U
+
+// Порядок слов заголовка; метка пишется последней
+enum {
+    HDR_MAGIC,
+    HDR_VERSION,
+    HDR_SEQ,
+    HDR_WORDS,
+    HDR_DATA_CRC,
+    HDR_CRC
+};
+
+static uint32_t rd(abpage_t *p_ab, uint32_t addr) {
+    p_ab->stats.load_reads++;
+    return p_ab->p_nvm->read(addr);
+}
+
+static bool header_valid(abpage_t const *p_ab, uint32_t const *p_hdr) {
+    return p_hdr[HDR_MAGIC] == ABPAGE_MAGIC &&
+           p_hdr[HDR_VERSION] == p_ab->version &&
+           p_hdr[HDR_WORDS] == p_ab->words &&
+           crc32_words(0, p_hdr, HDR_CRC) == p_hdr[HDR_CRC];
+}
+
+// Копирует данные страницы, считая CRC на ходу
+static bool data_load(abpage_t *p_ab, uint8_t page, uint32_t crc_expected, uint32_t *p_words) {
+    uint32_t addr = p_ab->addr[page] + ABPAGE_HEADER_WORDS * sizeof(uint32_t);
+    uint32_t crc = 0;
+
+    for (uint16_t i = 0; i < p_ab->words; i++) {
+        p_words[i] = rd(p_ab, addr + i * sizeof(uint32_t));
+        crc = crc32_words(crc, &p_words[i], 1);
+    }
+    return crc == crc_expected;
+}
+
+void abpage_init(abpage_t *p_ab, journal_nvm_t const *p_nvm,
+                 uint32_t addr_a, uint32_t addr_b, uint32_t version, uint16_t words) {
+    p_ab->p_nvm = p_nvm;
+    p_ab->addr[0] = addr_a;
+    p_ab->addr[1] = addr_b;
+    p_ab->version = version;
+    p_ab->words = words;
+    p_ab->active = -1;
+    p_ab->seq = 0;
+    p_ab->stats = (abpage_stats_t){ 0 };
+}
+
+bool abpage_load(abpage_t *p_ab, uint32_t *p_words) {
+    uint32_t hdr[2][ABPAGE_HEADER_WORDS];
+    bool valid[2];
+
+    p_ab->stats.load_reads = 0;
+    p_ab->active = -1;
+    for (uint8_t p = 0; p < 2; p++) {
+        for (uint32_t i = 0; i < ABPAGE_HEADER_WORDS; i++) {
+            hdr[p][i] = rd(p_ab, p_ab->addr[p] + i * sizeof(uint32_t));
+        }
+        valid[p] = header_valid(p_ab, hdr[p]);
+    }
+
+    // Сначала новейшая копия, затем вторая
+    uint8_t first = (valid[1] && (!valid[0] || (int32_t)(hdr[1][HDR_SEQ] - hdr[0][HDR_SEQ]) > 0)) ? 1 : 0;
+    for (uint8_t k = 0; k < 2; k++) {
+        uint8_t p = (uint8_t)(first ^ k);
+        if (!valid[p]) continue;
+        if (data_load(p_ab, p, hdr[p][HDR_DATA_CRC], p_words)) {
+            p_ab->active = (int8_t)p;
+            p_ab->seq = hdr[p][HDR_SEQ];
+            if (k) p_ab->stats.failovers++;
+            return true;
+        }
+    }
+
+    // Целой копии нет, но номер дальше старого: иначе после сбоя новая
+    // копия могла бы проиграть уцелевшему заголовку
+    for (uint8_t p = 0; p < 2; p++) {
+        if (valid[p] && (int32_t)(hdr[p][HDR_SEQ] - p_ab->seq) > 0) p_ab->seq = hdr[p][HDR_SEQ];
+    }
+    return false;
+}
+
+void abpage_save(abpage_t *p_ab, uint32_t const *p_words) {
+    // Без целой копии первой пишется B: на месте A может лежать старый
+    // формат без заголовка, он должен пережить оборванную запись
+    uint8_t page = (p_ab->active == 1) ? 0 : 1;
+    uint32_t addr = p_ab->addr[page];
+    journal_nvm_t const *nvm = p_ab->p_nvm;
+    uint32_t hdr[ABPAGE_HEADER_WORDS];
+
+    hdr[HDR_MAGIC] = ABPAGE_MAGIC;
+    hdr[HDR_VERSION] = p_ab->version;
+    hdr[HDR_SEQ] = p_ab->seq + 1;
+    hdr[HDR_WORDS] = p_ab->words;
+    hdr[HDR_DATA_CRC] = crc32_words(0, p_words, p_ab->words);
+    hdr[HDR_CRC] = crc32_words(0, hdr, HDR_CRC);
+
+    nvm->erase(addr);
+    p_ab->stats.erases++;
+    for (uint16_t i = 0; i < p_ab->words; i++) {
+        nvm->write(addr + (ABPAGE_HEADER_WORDS + i) * sizeof(uint32_t), p_words[i]);
+    }
+    for (uint32_t i = ABPAGE_HEADER_WORDS; i-- > 0;) {
+        nvm->write(addr + i * sizeof(uint32_t), hdr[i]);
+    }
+
+    p_ab->active = (int8_t)page;
+    p_ab->seq = hdr[HDR_SEQ];
+    p_ab->stats.saves++;
+}
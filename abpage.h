@@ -0,0 +1,47 @@
+#ifndef ABPAGE_H
+#define ABPAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "journal.h"
+
+// Снимок данных целиком на паре страниц A/B. Запись идёт на страницу, где
+// лежит не текущая копия: стирание, данные, заголовок, метка последней.
+// Заголовок - метка, версия формата, номер записи, длина, CRC-32 данных и
+// CRC-32 самого заголовка. При загрузке оба заголовка проверяются за один
+// проход, данные новейшей копии сверяются с CRC прямо при копировании; не
+// сошлись - берётся вторая копия без повторного чтения заголовков
+
+#define ABPAGE_HEADER_WORDS 6
+
+// Операций flash на abpage_save: стирание, данные и заголовок
+#define ABPAGE_SAVE_OPS(words) (1U + (words) + ABPAGE_HEADER_WORDS)
+
+typedef struct {
+    uint32_t saves;
+    uint32_t erases;
+    uint32_t failovers;      // новейшая копия битая, загружена предыдущая
+    uint32_t load_reads;     // чтений слов при последнем abpage_load
+} abpage_stats_t;
+
+typedef struct {
+    journal_nvm_t const * p_nvm;
+    uint32_t addr[2];
+    uint32_t version;        // версия формата данных
+    uint16_t words;          // слов данных
+    int8_t   active;         // страница текущей копии, -1 - нет
+    uint32_t seq;            // номер текущей копии
+    abpage_stats_t stats;
+} abpage_t;
+
+// Данные - не больше page_size - ABPAGE_HEADER_WORDS * 4 байт
+void abpage_init(abpage_t * p_ab, journal_nvm_t const * p_nvm,
+                 uint32_t addr_a, uint32_t addr_b, uint32_t version, uint16_t words);
+
+// Загружает новейшую целую копию в p_words. false - целой копии нет,
+// p_words при этом может быть испорчен
+bool abpage_load(abpage_t * p_ab, uint32_t * p_words);
+
+void abpage_save(abpage_t * p_ab, uint32_t const * p_words);
+
+#endif
@@ -0,0 +1,108 @@
+#include "anim.h"
+
+#define ANIM_U_ONE 65536U
+
+// Кривая перехода, u и результат - доли 0..65536
+static uint32_t ease_apply(anim_ease_t ease, uint32_t u) {
+    switch (ease) {
+        case ANIM_EASE_STEP:
+            return 0;
+        case ANIM_EASE_IN_OUT: {
+            // u^2 * (3 - 2u) в Q16
+            uint64_t uu = (uint64_t)u * u;
+            return (uint32_t)((uu * (3 * ANIM_U_ONE - 2 * u)) >> 32);
+        }
+        default:
+            return u;
+    }
+}
+
+static int32_t lerp_i32(int32_t a, int32_t b, uint32_t u) {
+    int64_t d = (int64_t)(b - a) * u;
+    // Округление к ближайшему в обе стороны
+    d += (d >= 0) ? ANIM_U_ONE / 2 : -(int64_t)(ANIM_U_ONE / 2);
+    return a + (int32_t)(d / (int64_t)ANIM_U_ONE);
+}
+
+color_hsv_t anim_lerp_hsv(color_hsv_t const *p_a, color_hsv_t const *p_b, uint32_t u) {
+    color_hsv_t out;
+    out.h = (uint16_t)lerp_i32(p_a->h, p_b->h, u);
+    out.s = (uint8_t)lerp_i32(p_a->s, p_b->s, u);
+    out.v = (uint8_t)lerp_i32(p_a->v, p_b->v, u);
+    return out;
+}
+
+color_hsv_t anim_lerp_hsv_wrap(color_hsv_t const *p_a, color_hsv_t const *p_b, uint32_t u) {
+    uint16_t ha = p_a->h;
+    uint16_t hb = p_b->h;
+    if (p_a->s == 0 || p_a->v == 0) ha = hb;
+    else if (p_b->s == 0 || p_b->v == 0) hb = ha;
+
+    color_hsv_t out;
+    out.h = (uint16_t)(ha + lerp_i32(0, (int16_t)(uint16_t)(hb - ha), u));
+    out.s = (uint8_t)lerp_i32(p_a->s, p_b->s, u);
+    out.v = (uint8_t)lerp_i32(p_a->v, p_b->v, u);
+    return out;
+}
+
+void anim_lerp_levels(uint16_t const *p_a, uint16_t const *p_b, uint16_t *p_out,
+                      uint32_t count, uint32_t u) {
+    for (uint32_t i = 0; i < count; i++) {
+        p_out[i] = (uint16_t)lerp_i32(p_a[i], p_b[i], u);
+    }
+}
+
+void anim_start(anim_t *p_anim, anim_key_t const *p_keys, uint16_t count,
+                int16_t loop_from, uint32_t now_ms) {
+    p_anim->p_keys = p_keys;
+    p_anim->count = count;
+    p_anim->loop_from = (loop_from >= 0 && loop_from < (int16_t)count) ? loop_from : ANIM_NO_LOOP;
+    p_anim->t0_ms = now_ms;
+}
+
+void anim_sample(anim_t const *p_anim, uint32_t now_ms, anim_sample_t *p_out) {
+    anim_key_t const *keys = p_anim->p_keys;
+    uint16_t n = p_anim->count;
+    bool loop = p_anim->loop_from != ANIM_NO_LOOP;
+    uint16_t loop_from = loop ? (uint16_t)p_anim->loop_from : 0;
+
+    p_out->seg = 0;
+    p_out->done = false;
+    if (n == 0) {
+        p_out->hsv = (color_hsv_t){ 0 };
+        p_out->done = true;
+        return;
+    }
+
+    // С повтором переходов n (последний ведёт к loop_from), без - n-1
+    uint16_t segs = loop ? n : n - 1;
+    uint32_t head = 0;
+    uint32_t period = 0;
+    for (uint16_t k = 0; k < segs; k++) {
+        if (loop && k >= loop_from) period += keys[k].ms;
+        else head += keys[k].ms;
+    }
+
+    uint32_t t = now_ms - p_anim->t0_ms;
+    if (loop && period && t >= head) {
+        t = head + (t - head) % period;
+    }
+
+    for (uint16_t k = 0; k < segs; k++) {
+        uint32_t ms = keys[k].ms;
+        if (t < ms) {
+            uint16_t next = (k + 1 < n) ? k + 1 : loop_from;
+            uint32_t u = (uint32_t)(((uint64_t)t << 16) / ms);
+            p_out->hsv = anim_lerp_hsv(&keys[k].hsv, &keys[next].hsv, ease_apply(keys[k].ease, u));
+            p_out->seg = k;
+            return;
+        }
+        t -= ms;
+    }
+
+    // Все переходы пройдены (или период повтора нулевой)
+    uint16_t last = loop ? loop_from : n - 1;
+    p_out->hsv = keys[last].hsv;
+    p_out->seg = last;
+    p_out->done = !loop;
+}
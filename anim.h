@@ -0,0 +1,61 @@
+#ifndef ANIM_H
+#define ANIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "color.h"
+
+// Ключевые кадры цвета с интерполяцией по прошедшему времени: пропущенные
+// тики пропускают кадры, но не растягивают анимацию. Модуль не зависит
+// от SDK, время передаёт вызывающий
+
+typedef enum {
+    ANIM_EASE_LINEAR,
+    ANIM_EASE_IN_OUT,      // smoothstep: плавный разгон и торможение
+    ANIM_EASE_STEP         // держит цвет ключа до следующего
+} anim_ease_t;
+
+// Ключ: цвет и переход к следующему ключу. Оттенок интерполируется как
+// число 0..65535, без перехода через 0 - для короткого пути по кругу ключи
+// задают с разницей не больше половины оборота
+typedef struct {
+    color_hsv_t hsv;
+    uint32_t    ms;        // длительность перехода к следующему ключу
+    anim_ease_t ease;
+} anim_key_t;
+
+#define ANIM_NO_LOOP (-1)
+
+// После последнего ключа анимация идёт к ключу loop_from и повторяется
+// с него; ANIM_NO_LOOP - останавливается на последнем ключе
+typedef struct {
+    anim_key_t const * p_keys;
+    uint16_t count;
+    int16_t  loop_from;
+    uint32_t t0_ms;
+} anim_t;
+
+typedef struct {
+    color_hsv_t hsv;
+    uint16_t    seg;       // индекс ключа, от которого идёт текущий переход
+    bool        done;      // без повтора: последний ключ достигнут
+} anim_sample_t;
+
+void anim_start(anim_t * p_anim, anim_key_t const * p_keys, uint16_t count,
+                int16_t loop_from, uint32_t now_ms);
+
+// Цвет на момент now_ms (тот же отсчёт, что и в anim_start)
+void anim_sample(anim_t const * p_anim, uint32_t now_ms, anim_sample_t * p_out);
+
+// Интерполяция a->b, u - доля пути 0..65536
+color_hsv_t anim_lerp_hsv(color_hsv_t const * p_a, color_hsv_t const * p_b, uint32_t u);
+
+// То же, но оттенок идёт по кратчайшей дуге, а у ахроматического конца
+// (S или V = 0) берётся от другого конца, чтобы не пробегать радугу
+color_hsv_t anim_lerp_hsv_wrap(color_hsv_t const * p_a, color_hsv_t const * p_b, uint32_t u);
+
+// Поэлементная интерполяция уровней 0..65535 (линейный свет)
+void anim_lerp_levels(uint16_t const * p_a, uint16_t const * p_b, uint16_t * p_out,
+                      uint32_t count, uint32_t u);
+
+#endif
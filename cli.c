@@ -5,13 +5,22 @@
 #include "nrf_cli.h"
 #include "nrf_cli_cdc_acm.h"
 #include "nrf_log.h"
+#include "app_util_platform.h"
 #include "app_usbd.h"
 #include "app_usbd_core.h"
 #include "app_usbd_serial_num.h"
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
-#include "nrfx_nvmc.h"
+#include "color.h"
+#include "perf.h"
+#include "led.h"
+#include "led_pwm.h"
+#include "led_strip.h"
+#include "anim.h"
+#include "nvm.h"
+#include "kvlog.h"
+#include "abpage.h"
+#include "persist.h"
 
 NRF_CLI_CDC_ACM_DEF(m_cli_cdc_acm_transport);
 
@@ -21,22 +30,96 @@ NRF_CLI_DEF(m_cli_cdc_acm,
             '\r', 
             4);
 
-extern volatile float m_h;
+extern volatile uint16_t m_h;
 extern volatile int m_s;
 extern volatile int m_v;
 
+// Старая страница палитры: только чтение, пока журнал палитры пуст
 #define COLORS_FLASH_ADDR 0x7E000
-#define COLORS_MAGIC 0xC0A0BEEF
+// v2: h в color_entry_t хранится углом COLOR_HUE_TURN на оборот
+#define COLORS_MAGIC 0xC0A1BEEF
+// v1: h в градусах 0..360, переводится в угол при чтении
+#define COLORS_MAGIC_DEG 0xC0A0BEEF
+
+// Журнал правок палитры: две страницы, ключ - номер слота
+#define PALETTE_LOG_ADDR 0x79000
+// Запись: имя (4 слова) и H/S/V
+#define PALETTE_WORDS (COLOR_NAME_LEN / 4 + 1)
+// Сброс правит каждый слот не больше раза
+#define PALETTE_FLUSH_OPS KVLOG_EDITS_OPS(PALETTE_WORDS, MAX_COLORS, MAX_COLORS)
+STATIC_ASSERT(PALETTE_FLUSH_OPS <= NVM_QUEUE_LEN);
 
 static color_entry_t m_colors[MAX_COLORS];
+static kvlog_t m_palette_log;
+// Слоты, правленные после последней записи журнала
+static uint32_t m_palette_dirty;
+
+// Сцена - копиями A/B; старый формат без CRC лежал в одной странице A
+#define SCENE_FLASH_ADDR 0x7D000
+#define SCENE_FLASH_B_ADDR 0x78000
+#define SCENE_MAGIC 0x5CE4E001
+#define SCENE_VERSION 1
+
+// Шаг сцены хранится по имени цвета из палитры: правка цвета меняет сцену
+typedef struct {
+    char     name[COLOR_NAME_LEN];
+    uint32_t hold_ms;
+    uint32_t fade_ms;
+} scene_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t loop;
+    scene_entry_t steps[SCENE_MAX_STEPS];
+} flash_scene_t;
+
+#define SCENE_WORDS (sizeof(flash_scene_t) / sizeof(uint32_t))
+#define SCENE_FLUSH_OPS ABPAGE_SAVE_OPS(SCENE_WORDS)
+STATIC_ASSERT(SCENE_FLUSH_OPS <= NVM_QUEUE_LEN);
+
+static flash_scene_t m_scene;
+static abpage_t m_scene_store;
+// Цвета сцены, разрешённые по именам при запуске; их читает отрисовка
+static scene_cue_t m_scene_cues[SCENE_MAX_STEPS];
 
 typedef struct {
     uint32_t magic;
     color_entry_t colors[MAX_COLORS];
 } flash_colors_t;
 
-static void hsv_to_rgb_for_cli(float h, int s, int v,
+static void hsv_to_rgb_for_cli(uint16_t h, int s, int v,
                                uint8_t *r, uint8_t *g, uint8_t *b);
+static void palette_changed(int idx);
+
+// Оттенок в градусах, можно с долями: "120", "120.5", "120.25"
+static bool parse_hue(const char *str, uint16_t *p_hue) {
+    char *end;
+    long deg = strtol(str, &end, 10);
+    long centi = 0;
+
+    if (*end == '.') {
+        int digits = 0;
+        end++;
+        while (*end >= '0' && *end <= '9' && digits < 2) {
+            centi = centi * 10 + (*end - '0');
+            end++;
+            digits++;
+        }
+        if (digits == 1) centi *= 10;
+    }
+
+    if (end == str || *end != '\0' || deg < 0 || deg > 360 || (deg == 360 && centi > 0))
+        return false;
+
+    *p_hue = (uint16_t)(((uint32_t)(deg * 100 + centi) * COLOR_HUE_TURN + 18000) / 36000);
+    return true;
+}
+
+// Угол -> сотые доли градуса для вывода
+static uint32_t hue_to_centideg(uint16_t hue) {
+    return ((uint32_t)hue * 36000 + COLOR_HUE_TURN / 2) / COLOR_HUE_TURN;
+}
 
 static int find_color_index(const char *name) {
     for (int i = 0; i < MAX_COLORS; i++) {
@@ -86,38 +169,18 @@ static void cmd_add_rgb(nrf_cli_t const *p_cli, size_t argc, char **argv) {
         return;
     }
 
-    float rf = r / 255.0f;
-    float gf = g / 255.0f;
-    float bf = b / 255.0f;
-
-    float max = fmaxf(rf, fmaxf(gf, bf));
-    float min = fminf(rf, fminf(gf, bf));
-    float delta = max - min;
-
-    float h = 0.0f;
-    if (delta > 0.0f) {
-        if (max == rf)
-            h = 60.0f * fmodf(((gf - bf) / delta), 6.0f);
-        else if (max == gf)
-            h = 60.0f * (((bf - rf) / delta) + 2.0f);
-        else
-            h = 60.0f * (((rf - gf) / delta) + 4.0f);
-
-        if (h < 0.0f) h += 360.0f;
-    }
+    color_hsv_t hsv;
+    color_rgb_to_hsv(r, g, b, &hsv);
 
-    float s = (max == 0.0f) ? 0.0f : (delta / max);
-    float v = max;
-
-    m_colors[slot].h = (uint16_t)h;
-    m_colors[slot].s = (uint8_t)(s * 100.0f);
-    m_colors[slot].v = (uint8_t)(v * 100.0f);
+    m_colors[slot].h = hsv.h;
+    m_colors[slot].s = hsv.s;
+    m_colors[slot].v = hsv.v;
     strncpy(m_colors[slot].name, argv[4], COLOR_NAME_LEN);
     m_colors[slot].used = true;
 
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
         "RGB: цвет '%s' добавлен\n", argv[4]);
-    save_colors_to_flash();
+    palette_changed(slot);
 }
 
 
@@ -141,7 +204,14 @@ static void cmd_add_hsv(nrf_cli_t const *p_cli, size_t argc, char **argv) {
         return;
     }
 
-    m_colors[slot].h = atoi(argv[1]);
+    uint16_t hue;
+    if (!parse_hue(argv[1], &hue)) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR,
+            "H должен быть 0-360\n");
+        return;
+    }
+
+    m_colors[slot].h = hue;
     m_colors[slot].s = atoi(argv[2]);
     m_colors[slot].v = atoi(argv[3]);
     strncpy(m_colors[slot].name, argv[4], COLOR_NAME_LEN);
@@ -149,7 +219,7 @@ static void cmd_add_hsv(nrf_cli_t const *p_cli, size_t argc, char **argv) {
 
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
         "HSV: цвет '%s' добавлен\n", argv[4]);
-    save_colors_to_flash();
+    palette_changed(slot);
 }
 
 static void cmd_add_current(nrf_cli_t const *p_cli, size_t argc, char **argv) {
@@ -166,7 +236,7 @@ static void cmd_add_current(nrf_cli_t const *p_cli, size_t argc, char **argv) {
         return;
     }
 
-    m_colors[slot].h = (uint16_t)m_h;
+    m_colors[slot].h = m_h;
     m_colors[slot].s = (uint8_t)m_s;
     m_colors[slot].v = (uint8_t)m_v;
     strncpy(m_colors[slot].name, argv[1], COLOR_NAME_LEN);
@@ -174,7 +244,7 @@ static void cmd_add_current(nrf_cli_t const *p_cli, size_t argc, char **argv) {
 
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
         "Текущий цвет сохранен под именем '%s'\n", argv[1]);
-    save_colors_to_flash();
+    palette_changed(slot);
 }
 
 static void cmd_apply_color(nrf_cli_t const *p_cli, size_t argc, char **argv) {
@@ -191,9 +261,8 @@ static void cmd_apply_color(nrf_cli_t const *p_cli, size_t argc, char **argv) {
         return;
     }
 
-    m_h = m_colors[idx].h;
-    m_s = m_colors[idx].s;
-    m_v = m_colors[idx].v;
+    color_hsv_t hsv = { .h = m_colors[idx].h, .s = m_colors[idx].s, .v = m_colors[idx].v };
+    led_color_set(&hsv);
 
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
         "Цвет с именем '%s' применён!\n", argv[1]);
@@ -206,7 +275,7 @@ static void cmd_list_colors(nrf_cli_t const *p_cli, size_t argc, char **argv) {
     for (int i = 0; i < MAX_COLORS; i++) {
         if (m_colors[i].used) {
             uint8_t r, g, b;
-            hsv_to_rgb_for_cli((float)m_colors[i].h,
+            hsv_to_rgb_for_cli(m_colors[i].h,
                    m_colors[i].s,
                    m_colors[i].v,
                    &r, &g, &b);
@@ -214,7 +283,7 @@ static void cmd_list_colors(nrf_cli_t const *p_cli, size_t argc, char **argv) {
             nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
                 "  %s: HSV(H=%d S=%d V=%d) RGB(%d,%d,%d)\n",
                 m_colors[i].name,
-                m_colors[i].h,
+                COLOR_HUE_TO_DEG(m_colors[i].h),
                 m_colors[i].s,
                 m_colors[i].v,
                 r, g, b);
@@ -237,45 +306,19 @@ static void cmd_del_color(nrf_cli_t const *p_cli, size_t argc, char **argv) {
     }
 
     m_colors[idx].used = false;
-    save_colors_to_flash();
+    palette_changed(idx);
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
         "Цвет с именем '%s' удалён\n", argv[1]);
 }
 
 
-static void hsv_to_rgb_for_cli(float h, int s, int v, uint8_t *r, uint8_t *g, uint8_t *b) {
-    float H = h;
-    float S = s / 100.0f;
-    float V = v / 100.0f;
-
-    if (S <= 0.0f) {
-        uint8_t val = (uint8_t)(V * 255);
-        *r = *g = *b = val;
-        return;
-    }
-
-    if (H >= 360.0f) H = 0.0f;
-    float hf = H / 60.0f;
-    int i = (int)floorf(hf);
-    float f = hf - i;
-    float p = V * (1.0f - S);
-    float q = V * (1.0f - S * f);
-    float t = V * (1.0f - S * (1.0f - f));
-
-    float rf=0, gf=0, bf=0;
-    switch (i) {
-        case 0: rf = V; gf = t; bf = p; break;
-        case 1: rf = q; gf = V; bf = p; break;
-        case 2: rf = p; gf = V; bf = t; break;
-        case 3: rf = p; gf = q; bf = V; break;
-        case 4: rf = t; gf = p; bf = V; break;
-        case 5:
-        default: rf = V; gf = p; bf = q; break;
-    }
-
-    *r = (uint8_t)(rf * 255);
-    *g = (uint8_t)(gf * 255);
-    *b = (uint8_t)(bf * 255);
+// 8-битный RGB для вывода в консоль, само преобразование - в color.c
+static void hsv_to_rgb_for_cli(uint16_t h, int s, int v, uint8_t *r, uint8_t *g, uint8_t *b) {
+    uint16_t r16, g16, b16;
+    color_hsv_to_rgb(h, s, v, 255, &r16, &g16, &b16);
+    *r = (uint8_t)r16;
+    *g = (uint8_t)g16;
+    *b = (uint8_t)b16;
 }
 
 static void cmd_rgb(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
@@ -295,41 +338,13 @@ static void cmd_rgb(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
         return;
     }
 
-    float r_norm = r_in / 255.0f;
-    float g_norm = g_in / 255.0f;
-    float b_norm = b_in / 255.0f;
-    
-    float max = r_norm;
-    if (g_norm > max) max = g_norm;
-    if (b_norm > max) max = b_norm;
-    
-    float min = r_norm;
-    if (g_norm < min) min = g_norm;
-    if (b_norm < min) min = b_norm;
-    
-    float delta = max - min;
-    
-    float h = 0;
-    if (delta != 0) {
-        if (max == r_norm) {
-            h = 60 * fmodf(((g_norm - b_norm) / delta), 6);
-        } else if (max == g_norm) {
-            h = 60 * (((b_norm - r_norm) / delta) + 2);
-        } else {
-            h = 60 * (((r_norm - g_norm) / delta) + 4);
-        }
-        
-        if (h < 0) h += 360;
-    }
-    
-    float s = (max == 0) ? 0 : (delta / max);
-    
-    m_h = h;
-    m_s = (int)(s * 100);
-    m_v = (int)(max * 100);
+    color_hsv_t hsv;
+    color_rgb_to_hsv(r_in, g_in, b_in, &hsv);
+
+    led_color_set(&hsv);
     
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Цвет установлен: R=%d G=%d B=%d (HSV: H=%d S=%d V=%d)\n", 
-                    r_in, g_in, b_in, (int)m_h, m_s, m_v);
+                    r_in, g_in, b_in, COLOR_HUE_TO_DEG(m_h), m_s, m_v);
 }
 
 static void cmd_hsv(nrf_cli_t const * p_cli, size_t argc, char ** argv)
@@ -341,20 +356,20 @@ static void cmd_hsv(nrf_cli_t const * p_cli, size_t argc, char ** argv)
         return;
     }
     
-    uint16_t h = atoi(argv[1]);
+    uint16_t h;
+    bool h_ok = parse_hue(argv[1], &h);
     uint8_t s = atoi(argv[2]);
     uint8_t v = atoi(argv[3]);
     
-    if (h > 360 || s > 100 || v > 100) {
+    if (!h_ok || s > 100 || v > 100) {
         nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Ошибка: H должен быть 0-360, S и V 0-100\n");
         return;
     }
     
-    m_h = (float)h;
-    m_s = s;
-    m_v = v;
+    color_hsv_t hsv = { .h = h, .s = s, .v = v };
+    led_color_set(&hsv);
     
-    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Цвет установлен в H=%d S=%d V=%d\n", h, s, v);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Цвет установлен в H=%s S=%d V=%d\n", argv[1], s, v);
 }
 
 static void cmd_status(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
@@ -365,7 +380,9 @@ static void cmd_status(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
     hsv_to_rgb_for_cli(m_h, m_s, m_v, &r, &g, &b);
     
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Текущие параметры цвета:\n");
-    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  HSV: H=%d, S=%d%%, V=%d%%\n", (int)m_h, m_s, m_v);
+    uint32_t h_cdeg = hue_to_centideg(m_h);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  HSV: H=%lu.%02lu, S=%d%%, V=%d%%\n",
+                    (unsigned long)(h_cdeg / 100), (unsigned long)(h_cdeg % 100), m_s, m_v);
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  RGB: R=%d, G=%d, B=%d\n", r, g, b);
 }
 
@@ -374,7 +391,7 @@ static void cmd_save(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
     (void)argv;
     
     save_settings();
-    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Настройки сохранены в память\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Настройки и палитра поставлены на запись во flash\n");
 }
 
 static void cmd_load(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
@@ -389,20 +406,824 @@ static void cmd_reset(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
     (void)argc;
     (void)argv;
     
-    m_h = (77.0f / 100.0f) * 360.0f; 
-    m_s = 100;
-    m_v = 100;
+    color_hsv_t hsv = { .h = LED_DEFAULT_H, .s = LED_DEFAULT_S, .v = LED_DEFAULT_V };
+    led_color_set(&hsv);
     
-    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Настройки сброшены по варианту #6577: H=%d, S=%d, V=%d\n", (int)m_h, m_s, m_v);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Настройки сброшены по варианту #6577: H=%d, S=%d, V=%d\n", COLOR_HUE_TO_DEG(m_h), m_s, m_v);
+}
+
+static void cmd_curve(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    if (argc == 2) {
+        color_curve_t curve;
+        for (curve = 0; curve < COLOR_CURVE_COUNT; curve++) {
+            if (strcmp(argv[1], color_curve_name(curve)) == 0) break;
+        }
+        if (curve == COLOR_CURVE_COUNT) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Кривая должна быть: linear, gamma2 или cie\n");
+            return;
+        }
+        color_curve_set(curve);
+        led_color_changed();
+    } else if (argc != 1) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Использование: curve [linear|gamma2|cie]\n");
+        return;
+    }
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Кривая яркости: %s\n", color_curve_name(color_curve_get()));
+}
+
+static void cmd_fade(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    uint32_t ms;
+    led_fade_space_t space;
+    led_fade_get(&ms, &space);
+
+    if (argc >= 2 && argc <= 3) {
+        char *end;
+        unsigned long val = strtoul(argv[1], &end, 10);
+        if (*end != '\0' || val > 60000) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Длительность должна быть 0-60000 мс\n");
+            return;
+        }
+        if (argc == 3) {
+            if (strcmp(argv[2], "hsv") == 0) space = LED_FADE_HSV;
+            else if (strcmp(argv[2], "rgb") == 0) space = LED_FADE_RGB;
+            else {
+                nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Пространство должно быть: hsv или rgb\n");
+                return;
+            }
+        }
+        ms = (uint32_t)val;
+        led_fade_set(ms, space);
+    } else if (argc != 1) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Использование: fade [<ms> [hsv|rgb]]\n");
+        return;
+    }
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Переход: %lu мс, %s\n", (unsigned long)ms,
+                    (space == LED_FADE_HSV) ? "hsv" : "rgb");
+}
+
+// effect <name> [period=ms] [h=] [s=] [v=] [duty=%] [min=] [steps=]
+static void cmd_effect(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    effect_id_t id;
+
+    if (argc == 1) {
+        if (led_effect_get(&id)) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Эффект: %s\n", effect_name(id));
+        } else {
+            nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Эффект не запущен\n");
+        }
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Доступны:");
+        for (id = 0; id < EFFECT_COUNT; id++) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, " %s", effect_name(id));
+        }
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "\n");
+        return;
+    }
+
+    if (strcmp(argv[1], "stop") == 0) {
+        led_effect_stop();
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Эффект остановлен\n");
+        return;
+    }
+
+    id = effect_find(argv[1]);
+    if (id == EFFECT_COUNT) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Неизвестный эффект '%s'\n", argv[1]);
+        return;
+    }
+
+    effect_params_t params;
+    effect_defaults(id, &params);
+    params.hsv.h = m_h;
+    params.hsv.s = (uint8_t)m_s;
+    params.hsv.v = (uint8_t)m_v;
+
+    for (size_t i = 2; i < argc; i++) {
+        char *val = strchr(argv[i], '=');
+        char *end = NULL;
+        unsigned long num = 0;
+        if (val) {
+            *val++ = '\0';
+            num = strtoul(val, &end, 10);
+        }
+        if (!val || *end != '\0') {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Параметр задаётся как имя=число: %s\n", argv[i]);
+            return;
+        }
+
+        bool ok = true;
+        if (strcmp(argv[i], "period") == 0) {
+            ok = num >= 1 && num <= 600000;
+            params.period_ms = (uint32_t)num;
+        } else if (strcmp(argv[i], "h") == 0) {
+            ok = parse_hue(val, &params.hsv.h);
+        } else if (strcmp(argv[i], "s") == 0) {
+            ok = num <= 100;
+            params.hsv.s = (uint8_t)num;
+        } else if (strcmp(argv[i], "v") == 0) {
+            ok = num <= 100;
+            params.hsv.v = (uint8_t)num;
+        } else if (strcmp(argv[i], "duty") == 0) {
+            ok = num >= 1 && num <= 99;
+            params.duty = (uint8_t)num;
+        } else if (strcmp(argv[i], "min") == 0) {
+            ok = num <= 100;
+            params.min_v = (uint8_t)num;
+        } else if (strcmp(argv[i], "steps") == 0) {
+            ok = num >= 2 && num <= EFFECT_CYCLE_MAX_STEPS;
+            params.steps = (uint8_t)num;
+        } else {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Неизвестный параметр '%s'\n", argv[i]);
+            return;
+        }
+        if (!ok) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Недопустимое значение %s=%s\n", argv[i], val);
+            return;
+        }
+    }
+
+    // Аппаратная анимация перекрыла бы вывод эффекта
+    led_pwm_anim_stop();
+    led_effect_start(id, &params);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Эффект %s запущен\n", effect_name(id));
+}
+
+// Пишется на страницу, где нет текущей копии: оборванная запись оставит
+// прежнюю сцену целой. Зовёт persist, когда правки затихли: серия правок
+// сцены стоит одного стирания
+static void scene_flush(void) {
+    m_scene.magic = SCENE_MAGIC;
+    abpage_save(&m_scene_store, (uint32_t const *)&m_scene);
+}
+
+static void scene_changed(void) {
+    persist_mark(PERSIST_SCENE);
+}
+
+// Старые страницы без CRC писались стиранием и записью структуры с начала
+// страницы: за ней всё должно быть стёрто. Так отсекаются оборванное
+// стирание и мусор, которые случайно прошли проверку метки
+static bool legacy_tail_erased(uint32_t addr, uint32_t bytes) {
+    uint32_t const *p_page = (uint32_t const *)(uintptr_t)addr;
+
+    for (uint32_t i = (bytes + 3) / sizeof(uint32_t); i < NVM_PAGE_SIZE / sizeof(uint32_t); i++) {
+        if (p_page[i] != JOURNAL_ERASED) return false;
+    }
+    return true;
+}
+
+static void load_scene_from_flash(void) {
+    flash_scene_t const *p = (flash_scene_t const *)SCENE_FLASH_ADDR;
+
+    abpage_init(&m_scene_store, nvm_async(), SCENE_FLASH_ADDR, SCENE_FLASH_B_ADDR,
+                SCENE_VERSION, SCENE_WORDS);
+    persist_register(PERSIST_SCENE, scene_flush, SCENE_FLUSH_OPS);
+    if (abpage_load(&m_scene_store, (uint32_t *)&m_scene) && m_scene.count <= SCENE_MAX_STEPS)
+        return;
+
+    memset(&m_scene, 0, sizeof(m_scene));
+    if (p->magic != SCENE_MAGIC || p->count > SCENE_MAX_STEPS || p->loop > 1 ||
+        !legacy_tail_erased(SCENE_FLASH_ADDR, sizeof(*p)))
+        return;
+
+    memcpy(&m_scene, p, sizeof(m_scene));
+    // Копия с CRC ляжет в B, старая страница на месте A доживёт до её конца
+    scene_changed();
+}
+
+static void cmd_scene(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    if (argc == 5 && strcmp(argv[1], "add") == 0) {
+        char *end_hold, *end_fade;
+        unsigned long hold = strtoul(argv[3], &end_hold, 10);
+        unsigned long fade = strtoul(argv[4], &end_fade, 10);
+        if (*end_hold != '\0' || *end_fade != '\0' || hold > 3600000 || fade > 600000) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Время удержания до 3600000 мс, перехода до 600000 мс\n");
+            return;
+        }
+        if (find_color_index(argv[2]) < 0) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Цвет не найден\n");
+            return;
+        }
+        if (m_scene.count >= SCENE_MAX_STEPS) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Максимальное число шагов = %d\n", SCENE_MAX_STEPS);
+            return;
+        }
+
+        scene_entry_t *p_step = &m_scene.steps[m_scene.count++];
+        memset(p_step->name, 0, COLOR_NAME_LEN);
+        strncpy(p_step->name, argv[2], COLOR_NAME_LEN);
+        p_step->hold_ms = (uint32_t)hold;
+        p_step->fade_ms = (uint32_t)fade;
+        scene_changed();
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Шаг %lu: '%s'\n", (unsigned long)m_scene.count, argv[2]);
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        led_scene_stop();
+        m_scene.count = 0;
+        scene_changed();
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Сцена очищена\n");
+        return;
+    }
+
+    if (argc == 3 && strcmp(argv[1], "loop") == 0) {
+        bool on = strcmp(argv[2], "on") == 0;
+        if (!on && strcmp(argv[2], "off") != 0) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Использование: scene loop on|off\n");
+            return;
+        }
+        m_scene.loop = on;
+        scene_changed();
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Повтор сцены: %s\n", on ? "вкл" : "выкл");
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "play") == 0) {
+        if (m_scene.count == 0) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Сцена пуста\n");
+            return;
+        }
+        // Имена разрешаются один раз, дальше тик не ищет по палитре
+        for (uint32_t i = 0; i < m_scene.count; i++) {
+            int idx = find_color_index(m_scene.steps[i].name);
+            if (idx < 0) {
+                nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Цвет '%.16s' не найден\n", m_scene.steps[i].name);
+                return;
+            }
+            m_scene_cues[i].hsv.h = m_colors[idx].h;
+            m_scene_cues[i].hsv.s = m_colors[idx].s;
+            m_scene_cues[i].hsv.v = m_colors[idx].v;
+            m_scene_cues[i].hold_ms = m_scene.steps[i].hold_ms;
+            m_scene_cues[i].fade_ms = m_scene.steps[i].fade_ms;
+        }
+        led_pwm_anim_stop();
+        led_scene_start(m_scene_cues, (uint16_t)m_scene.count, m_scene.loop != 0);
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Сцена запущена\n");
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "stop") == 0) {
+        led_scene_stop();
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Сцена остановлена\n");
+        return;
+    }
+
+    if (argc == 1 || (argc == 2 && strcmp(argv[1], "list") == 0)) {
+        uint16_t cur;
+        bool done;
+        bool playing = led_scene_get(&cur, &done);
+
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Сцена, %lu шаг(ов), повтор %s%s:\n",
+                        (unsigned long)m_scene.count, m_scene.loop ? "вкл" : "выкл",
+                        playing ? (done ? ", доиграна" : ", играет") : "");
+        for (uint32_t i = 0; i < m_scene.count; i++) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "%c %lu. %.16s: держать %lu мс, переход %lu мс\n",
+                            (playing && i == cur) ? '>' : ' ', (unsigned long)(i + 1),
+                            m_scene.steps[i].name, (unsigned long)m_scene.steps[i].hold_ms,
+                            (unsigned long)m_scene.steps[i].fade_ms);
+        }
+        return;
+    }
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_ERROR,
+        "Использование: scene add <name> <hold_ms> <fade_ms> | clear | loop on|off | list | play | stop\n");
+}
+
+static void cmd_hold(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    led_hold_profile_t prof;
+    led_hold_profile_get(&prof);
+
+    if (argc == 5 && strcmp(argv[1], "accel") == 0) {
+        char *e1, *e2, *e3;
+        unsigned long delay = strtoul(argv[2], &e1, 10);
+        unsigned long ramp = strtoul(argv[3], &e2, 10);
+        unsigned long max_x = strtoul(argv[4], &e3, 10);
+        if (*e1 != '\0' || *e2 != '\0' || *e3 != '\0' || delay > 10000 || ramp > 10000 ||
+            max_x < 1 || max_x > LED_HOLD_MAX_X_LIMIT) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Задержка и разгон 0-10000 мс, множитель 1-%u\n",
+                            LED_HOLD_MAX_X_LIMIT);
+            return;
+        }
+        prof.delay_ms = (uint32_t)delay;
+        prof.ramp_ms = (uint32_t)ramp;
+        prof.max_x = (uint32_t)max_x;
+    } else if (argc == 3 && strcmp(argv[1], "fine") == 0) {
+        bool on = strcmp(argv[2], "on") == 0;
+        if (!on && strcmp(argv[2], "off") != 0) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Использование: hold fine on|off\n");
+            return;
+        }
+        prof.fine = on;
+    } else if (argc != 1) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR,
+            "Использование: hold [accel <delay_ms> <ramp_ms> <max_x> | fine on|off]\n");
+        return;
+    }
+
+    if (argc != 1) {
+        led_hold_profile_set(&prof);
+        led_hold_profile_save();
+    }
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Удержание: %s\n", prof.fine ? "точный режим" : "с разгоном");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  базовая скорость %lu мс, затем до x%lu за %lu мс\n",
+                    (unsigned long)prof.delay_ms, (unsigned long)prof.max_x, (unsigned long)prof.ramp_ms);
+}
+
+static void cmd_flash_stats(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    (void)argc;
+    (void)argv;
+
+    journal_stats_t js;
+    led_settings_journal_stats_get(&js);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Журнал настроек:\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  записей: %lu, стираний страниц: %lu\n",
+                    (unsigned long)js.appends, (unsigned long)js.erases);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  чтений слов при загрузке: %lu\n", (unsigned long)js.mount_reads);
+
+    nvm_stats_t ns;
+    nvm_stats_get(&ns);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Очередь NVM (шаг до %u мс):\n", NVM_STALL_BUDGET_MS);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  стираний: %lu (%lu кусков), слов: %lu\n",
+                    (unsigned long)ns.erases, (unsigned long)ns.erase_slices, (unsigned long)ns.words);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  самый долгий шаг: %lu мкс\n", (unsigned long)ns.stall_max_us);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  переполнений: %lu, сбоев NVMC: %lu\n",
+                    (unsigned long)ns.overflows, (unsigned long)ns.failed);
+
+    kvlog_stats_t ps;
+    palette_log_stats_get(&ps);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Журнал палитры:\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  правок: %lu, уплотнений: %lu, стираний: %lu\n",
+                    (unsigned long)ps.appends, (unsigned long)ps.compactions, (unsigned long)ps.erases);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  записано слов: %lu, чтений при загрузке: %lu\n",
+                    (unsigned long)ps.words, (unsigned long)ps.mount_reads);
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Сцена (копии A/B):\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  записей: %lu, копия: %c, переходов на старую копию: %lu\n",
+                    (unsigned long)m_scene_store.stats.saves,
+                    (m_scene_store.active < 0) ? '-' : (char)('A' + m_scene_store.active),
+                    (unsigned long)m_scene_store.stats.failovers);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  чтений слов при загрузке: %lu\n",
+                    (unsigned long)m_scene_store.stats.load_reads);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Проверка и загрузка flash при старте: %lu мкс\n",
+                    (unsigned long)led_flash_load_us());
+
+    persist_stats_t cs;
+    persist_stats_get(&cs);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Отложенная запись (простой %u мс):\n", PERSIST_IDLE_MS);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  правок: %lu, записано частей: %lu\n",
+                    (unsigned long)cs.marks, (unsigned long)cs.flushes);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  сбросов по простою: %lu, по save: %lu, по POFWARN: %lu\n",
+                    (unsigned long)cs.idle, (unsigned long)cs.requested, (unsigned long)cs.pof);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  отложено до места в очереди NVM: %lu\n",
+                    (unsigned long)cs.deferred);
+}
+
+static void cmd_render_stats(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    (void)argc;
+    (void)argv;
+
+    led_render_stats_t st;
+    led_render_stats_get(&st);
+
+    uint32_t skipped = st.ticks - st.converted;
+    uint32_t avg = st.converted ? st.convert_cycles / st.converted : 0;
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Отрисовка:\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  тиков: %lu\n", (unsigned long)st.ticks);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  пересчётов цвета: %lu (%lu тактов в среднем)\n",
+                    (unsigned long)st.converted, (unsigned long)avg);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  записей в ШИМ: %lu\n", (unsigned long)st.written);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  пропущено пересчётов: %lu, записей: %lu\n",
+                    (unsigned long)skipped, (unsigned long)(st.ticks - st.written));
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  сэкономлено тактов: ~%lu\n", (unsigned long)(skipped * avg));
+
+    led_pwm_stats_t pwm;
+    led_pwm_stats_get(&pwm);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  переключений буферов ШИМ: %lu, отложено запросов: %lu, объединено: %lu\n",
+                    (unsigned long)pwm.swaps, (unsigned long)pwm.deferred, (unsigned long)pwm.coalesced);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  задержка применения: %lu мкс (макс. %lu мкс)\n",
+                    (unsigned long)(pwm.latency_last / PERF_CYCLES_PER_US),
+                    (unsigned long)(pwm.latency_max / PERF_CYCLES_PER_US));
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  остановок ШИМ: %lu, запусков: %lu (%lu мкс)\n",
+                    (unsigned long)pwm.suspends, (unsigned long)pwm.resumes,
+                    (unsigned long)(pwm.resume_cycles / PERF_CYCLES_PER_US));
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  остановок main_timer: %lu, пробуждений: %lu (%lu мкс до кадра)\n",
+                    (unsigned long)st.sleeps, (unsigned long)st.wakes,
+                    (unsigned long)(st.wake_cycles / PERF_CYCLES_PER_US));
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  кадров перехода: %lu (%lu тактов в среднем)\n",
+                    (unsigned long)st.fade_frames,
+                    (unsigned long)(st.fade_frames ? st.fade_cycles / st.fade_frames : 0));
+}
+
+// Частоты считаются по приросту счётчиков с прошлого вызова команды
+static void cmd_power_stats(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    (void)argc;
+    (void)argv;
+
+    static led_power_stats_t prev;
+    static bool have_prev;
+
+    led_power_stats_t st;
+    led_power_stats_get(&st);
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Пробуждения:\n");
+    if (st.tick_ms) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  main_timer: каждые %lu мс\n", (unsigned long)st.tick_ms);
+    } else {
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  main_timer: остановлен\n");
+    }
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  выходов из WFE: %lu, прерываний RTC: %lu, тиков: %lu\n",
+                    (unsigned long)st.wakeups, (unsigned long)st.rtc_irqs, (unsigned long)st.ticks);
+
+    uint32_t dt = have_prev ? st.time_ms - prev.time_ms : 0;
+    if (dt) {
+        // Сотые доли в секунду, чтобы не тянуть float в printf
+        uint64_t k = 100ULL * 1000;
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  за %lu мс, в секунду:\n", (unsigned long)dt);
+        uint32_t rates[3] = {
+            (uint32_t)((st.wakeups - prev.wakeups) * k / dt),
+            (uint32_t)((st.rtc_irqs - prev.rtc_irqs) * k / dt),
+            (uint32_t)((st.ticks - prev.ticks) * k / dt)
+        };
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  выходов из WFE: %lu.%02lu, прерываний RTC: %lu.%02lu, тиков: %lu.%02lu\n",
+                        (unsigned long)(rates[0] / 100), (unsigned long)(rates[0] % 100),
+                        (unsigned long)(rates[1] / 100), (unsigned long)(rates[1] % 100),
+                        (unsigned long)(rates[2] / 100), (unsigned long)(rates[2] % 100));
+    }
+    prev = st;
+    have_prev = true;
+}
+
+// Кадр анимации из HSV через текущую кривую яркости, одинаковый для всех фикстур
+static void anim_frame_hsv(uint16_t idx, uint16_t h, uint8_t s, uint8_t v) {
+    color_hsv_t hsv[LED_PWM_FIXTURES];
+    uint16_t levels[LED_PWM_FIXTURES * 3];
+    for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+        hsv[f].h = h;
+        hsv[f].s = s;
+        hsv[f].v = v;
+    }
+    color_hsv_to_level16_batch(hsv, LED_PWM_FIXTURES, levels, 3);
+    led_pwm_anim_frame_set(idx, levels);
+}
+
+static void cmd_anim(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    uint16_t count = LED_PWM_ANIM_MAX_FRAMES;
+
+    if (argc == 2 && strcmp(argv[1], "stop") == 0) {
+        led_pwm_anim_stop();
+        // Перерисовка: чёрный цвет снова остановит ШИМ
+        led_color_changed();
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Анимация остановлена\n");
+        return;
+    }
+
+    if (argc == 3 && strcmp(argv[1], "hue") == 0) {
+        long period = atol(argv[2]);
+        if (period < count) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Период не меньше %u мс\n", count);
+            return;
+        }
+
+        led_effect_stop();
+        led_scene_stop();
+        led_pwm_anim_stop();
+        for (uint16_t i = 0; i < count; i++) {
+            uint16_t h = (uint16_t)(m_h + (uint32_t)i * COLOR_HUE_TURN / count);
+            anim_frame_hsv(i, h, (uint8_t)m_s, (uint8_t)m_v);
+        }
+        led_pwm_anim_start(count, (uint32_t)((uint64_t)period * 1000 / count));
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Вращение оттенка: %ld мс на оборот\n", period);
+        return;
+    }
+
+    if (argc == 5 && strcmp(argv[1], "fade") == 0) {
+        int a = find_color_index(argv[2]);
+        int b = find_color_index(argv[3]);
+        long period = atol(argv[4]);
+        if (a < 0 || b < 0) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Цвет не найден\n");
+            return;
+        }
+        if (period < count) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Период не меньше %u мс\n", count);
+            return;
+        }
+
+        // Туда и обратно, оттенок по короткой дуге
+        uint16_t half = count / 2;
+        int32_t dh = (int16_t)(uint16_t)(m_colors[b].h - m_colors[a].h);
+        int32_t ds = (int32_t)m_colors[b].s - m_colors[a].s;
+        int32_t dv = (int32_t)m_colors[b].v - m_colors[a].v;
+
+        led_effect_stop();
+        led_scene_stop();
+        led_pwm_anim_stop();
+        for (uint16_t i = 0; i < half; i++) {
+            uint16_t h = (uint16_t)(m_colors[a].h + dh * i / half);
+            uint8_t s = (uint8_t)(m_colors[a].s + ds * i / half);
+            uint8_t v = (uint8_t)(m_colors[a].v + dv * i / half);
+            anim_frame_hsv(i, h, s, v);
+            anim_frame_hsv((uint16_t)(count - 1 - i),
+                           (uint16_t)(m_colors[a].h + dh * (i + 1) / half),
+                           (uint8_t)(m_colors[a].s + ds * (i + 1) / half),
+                           (uint8_t)(m_colors[a].v + dv * (i + 1) / half));
+        }
+        led_pwm_anim_start(count, (uint32_t)((uint64_t)period * 1000 / count));
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Переход '%s' <-> '%s': %ld мс\n",
+                        argv[2], argv[3], period);
+        return;
+    }
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_ERROR,
+        "Использование: anim hue <period_ms> | anim fade <name1> <name2> <period_ms> | anim stop\n");
+}
+
+static void cmd_fixture(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    int idx = argc >= 2 ? atoi(argv[1]) : -1;
+
+    if (idx < 0 || idx >= LED_PWM_FIXTURES || (argc != 3 && argc != 5)) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR,
+            "Использование: fixture <0-%d> <h> <s> <v> | fixture <n> common\n", LED_PWM_FIXTURES - 1);
+        return;
+    }
+
+    if (argc == 3) {
+        if (strcmp(argv[2], "common") != 0) {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Ожидалось 'common'\n");
+            return;
+        }
+        led_fixture_set((uint8_t)idx, NULL);
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Фикстура %d повторяет общий цвет\n", idx);
+        return;
+    }
+
+    color_hsv_t hsv;
+    int s = atoi(argv[3]);
+    int v = atoi(argv[4]);
+    if (!parse_hue(argv[2], &hsv.h) || s < 0 || s > 100 || v < 0 || v > 100) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Неверные значения HSV\n");
+        return;
+    }
+    hsv.s = (uint8_t)s;
+    hsv.v = (uint8_t)v;
+    led_fixture_set((uint8_t)idx, &hsv);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Фикстура %d: свой цвет\n", idx);
+}
+
+#if LED_STRIP_ENABLED
+#define STRIP_BENCH_FRAMES 20
+
+static const uint16_t m_strip_bench_sizes[] = { 60, 300, 1000 };
+
+// Вывод на ленту ведёт главный цикл (strip_process из usb_cli_process):
+// команда только ставит задачу, поэтому пока лента занята кадром, очередь
+// flash и CLI продолжают обслуживаться
+typedef struct {
+    nrf_cli_t const * p_cli;
+    uint16_t show;          // пикселей в кадре strip, ждущем вывода; 0 - нет
+    bool     bench;
+    bool     drawn;         // кадр замера нарисован, ждёт led_strip_show
+    uint8_t  size;          // индекс в m_strip_bench_sizes
+    uint8_t  frame;
+    uint32_t t0;
+    led_strip_stats_t before;
+} strip_job_t;
+
+static strip_job_t m_strip_job;
+
+// Шаг замера; false - ждём ленту
+static bool strip_bench_step(strip_job_t * p_job) {
+    uint16_t n = m_strip_bench_sizes[p_job->size];
+
+    if (n > LED_STRIP_MAX_PIXELS) {
+        nrf_cli_fprintf(p_job->p_cli, NRF_CLI_NORMAL, "  %4u пикс.: больше LED_STRIP_MAX_PIXELS\n", n);
+    } else if (p_job->frame < STRIP_BENCH_FRAMES) {
+        if (!p_job->drawn) {
+            // Отсчёт от свободной ленты: предыдущий кадр не входит в замер
+            if (p_job->frame == 0) {
+                if (led_strip_busy()) return false;
+                led_strip_stats_get(&p_job->before);
+                p_job->t0 = perf_cycles();
+            }
+            for (uint16_t i = 0; i < n; i++) {
+                uint8_t c = (uint8_t)(i + p_job->frame * 8);
+                led_strip_pixel_set(i, c, (uint8_t)(255 - c), (uint8_t)(c ^ 0x55), 0);
+            }
+            p_job->drawn = true;
+        }
+        if (!led_strip_show(n)) return false;
+        p_job->drawn = false;
+        p_job->frame++;
+        return true;
+    } else {
+        if (led_strip_busy()) return false;
+
+        led_strip_stats_t after;
+        uint32_t cycles = perf_cycles() - p_job->t0;
+        led_strip_stats_get(&after);
+
+        uint32_t fps10 = (uint32_t)((uint64_t)STRIP_BENCH_FRAMES * PERF_CYCLES_PER_US * 10000000U / cycles);
+        nrf_cli_fprintf(p_job->p_cli, NRF_CLI_NORMAL,
+            "  %4u пикс.: %lu.%lu кадр/с, кадр %lu мкс, опозданий чанков %lu\n",
+            n, (unsigned long)(fps10 / 10), (unsigned long)(fps10 % 10),
+            (unsigned long)(after.frame_cycles / PERF_CYCLES_PER_US),
+            (unsigned long)(after.underruns - p_job->before.underruns));
+    }
+
+    p_job->frame = 0;
+    if (++p_job->size == sizeof(m_strip_bench_sizes) / sizeof(m_strip_bench_sizes[0])) {
+        p_job->bench = false;
+    }
+    return true;
+}
+
+static void strip_process(void) {
+    strip_job_t * p_job = &m_strip_job;
+
+    if (p_job->show != 0 && led_strip_show(p_job->show)) {
+        nrf_cli_fprintf(p_job->p_cli, NRF_CLI_NORMAL, "Лента: %u пикселей\n", p_job->show);
+        p_job->show = 0;
+    }
+    while (p_job->bench && strip_bench_step(p_job)) {
+    }
+}
+
+static void cmd_strip(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    if (argc != 4 && argc != 5) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR,
+            "Использование: strip <h> <s> <v> [count]\n");
+        return;
+    }
+    if (m_strip_job.bench) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Лента занята замером\n");
+        return;
+    }
+
+    color_hsv_t hsv;
+    int s = atoi(argv[2]);
+    int v = atoi(argv[3]);
+    int count = (argc == 5) ? atoi(argv[4]) : LED_STRIP_MAX_PIXELS;
+    if (!parse_hue(argv[1], &hsv.h) || s < 0 || s > 100 || v < 0 || v > 100 ||
+        count < 1 || count > LED_STRIP_MAX_PIXELS) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Неверные параметры\n");
+        return;
+    }
+    hsv.s = (uint8_t)s;
+    hsv.v = (uint8_t)v;
+
+    uint16_t rgb[3];
+    color_hsv_to_level16_batch(&hsv, 1, rgb, 3);
+    for (int i = 0; i < count; i++) {
+        led_strip_pixel_set((uint16_t)i, rgb[0] >> 8, rgb[1] >> 8, rgb[2] >> 8, 0);
+    }
+    // Буфер рисования свой, кадр уйдёт, как только лента освободится
+    m_strip_job.p_cli = p_cli;
+    m_strip_job.show = (uint16_t)count;
+    strip_process();
+}
+
+// Кадры/с при выводе подряд для типовых длин ленты. Кадры выдаёт главный
+// цикл, результат печатается по мере готовности
+static void cmd_strip_bench(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    (void)argc;
+    (void)argv;
+
+    if (m_strip_job.bench) {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Замер уже идёт\n");
+        return;
+    }
+    // Ждущий кадр strip рисовался в тот же буфер: выдаём его до замера
+    m_strip_job = (strip_job_t){ .p_cli = p_cli, .show = m_strip_job.show, .bench = true };
+    strip_process();
+}
+#endif
+
+#if COLOR_BENCH_ENABLED
+#define BENCH_PWM_TOP 1000U
+#define BENCH_BATCH_SIZE 120
+
+static color_hsv_t m_bench_in[BENCH_BATCH_SIZE];
+static uint16_t m_bench_out[BENCH_BATCH_SIZE * 3];
+
+static void cmd_bench_color(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    (void)argc;
+    (void)argv;
+
+    uint32_t cyc_int = 0, cyc_float = 0, count = 0;
+    int max_diff = 0;
+    uint16_t r, g, b, rr, gr, br;
+
+    perf_cycles_init();
+    for (int h = 0; h < 360; h += 3) {
+        for (int s = 0; s <= 100; s += 10) {
+            for (int v = 0; v <= 100; v += 10) {
+                uint16_t hue = (uint16_t)(((uint32_t)h * COLOR_HUE_TURN + 180) / 360);
+
+                uint32_t t0 = perf_cycles();
+                color_hsv_to_rgb(hue, s, v, BENCH_PWM_TOP, &r, &g, &b);
+                uint32_t t1 = perf_cycles();
+                color_hsv_to_rgb_ref((float)h, s, v, BENCH_PWM_TOP, &rr, &gr, &br);
+                uint32_t t2 = perf_cycles();
+
+                cyc_int += t1 - t0;
+                cyc_float += t2 - t1;
+                count++;
+
+                int d = abs((int)r - rr);
+                if (abs((int)g - gr) > d) d = abs((int)g - gr);
+                if (abs((int)b - br) > d) d = abs((int)b - br);
+                if (d > max_diff) max_diff = d;
+            }
+        }
+    }
+
+    for (int i = 0; i < BENCH_BATCH_SIZE; i++) {
+        m_bench_in[i].h = (uint16_t)(i * (COLOR_HUE_TURN / BENCH_BATCH_SIZE));
+        m_bench_in[i].s = 100 - (i % 50);
+        m_bench_in[i].v = 50 + (i % 51);
+    }
+    uint32_t t0 = perf_cycles();
+    color_hsv_to_rgb_batch(m_bench_in, BENCH_BATCH_SIZE, BENCH_PWM_TOP, m_bench_out, 3);
+    uint32_t cyc_batch = perf_cycles() - t0;
+
+    uint32_t cyc_rgb = 0, count_rgb = 0;
+    color_hsv_t hsv;
+    for (int r = 0; r < 256; r += 15) {
+        for (int g = 0; g < 256; g += 15) {
+            for (int b = 0; b < 256; b += 15) {
+                t0 = perf_cycles();
+                color_rgb_to_hsv(r, g, b, &hsv);
+                cyc_rgb += perf_cycles() - t0;
+                count_rgb++;
+            }
+        }
+    }
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "HSV->RGB, %lu преобразований:\n", (unsigned long)count);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  int:   %lu тактов/вызов\n", (unsigned long)(cyc_int / count));
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  float: %lu тактов/вызов\n", (unsigned long)(cyc_float / count));
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  batch: %lu тактов/цвет\n", (unsigned long)(cyc_batch / BENCH_BATCH_SIZE));
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  макс. расхождение: %d из %u\n", max_diff, BENCH_PWM_TOP);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "RGB->HSV: %lu тактов/вызов\n", (unsigned long)(cyc_rgb / count_rgb));
 }
 
+#define BENCH_FADE_FRAMES 256
+
+// Та же работа, что и кадр перехода в отрисовке, на всех фикстурах
+static void cmd_bench_fade(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
+    (void)argc;
+    (void)argv;
+
+    color_hsv_t from[LED_PWM_FIXTURES], to[LED_PWM_FIXTURES], out_hsv[LED_PWM_FIXTURES];
+    uint16_t from_lvl[LED_PWM_FIXTURES * 3], to_lvl[LED_PWM_FIXTURES * 3];
+    uint16_t out[LED_PWM_FIXTURES * 3];
+
+    for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+        from[f] = (color_hsv_t){ .h = (uint16_t)(f * COLOR_HUE_TURN / 8), .s = 100, .v = 20 };
+        to[f] = (color_hsv_t){ .h = (uint16_t)(COLOR_HUE_TURN / 2 - f * COLOR_HUE_TURN / 8), .s = 60, .v = 100 };
+    }
+    color_hsv_to_level16_batch(from, LED_PWM_FIXTURES, from_lvl, 3);
+    color_hsv_to_level16_batch(to, LED_PWM_FIXTURES, to_lvl, 3);
+
+    uint32_t cyc_hsv = 0, cyc_rgb = 0;
+    perf_cycles_init();
+    for (uint32_t i = 0; i < BENCH_FADE_FRAMES; i++) {
+        uint32_t u = i * (65536U / BENCH_FADE_FRAMES);
+
+        uint32_t t0 = perf_cycles();
+        for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+            out_hsv[f] = anim_lerp_hsv_wrap(&from[f], &to[f], u);
+        }
+        color_hsv_to_level16_batch(out_hsv, LED_PWM_FIXTURES, out, 3);
+        uint32_t t1 = perf_cycles();
+        for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+            out_hsv[f] = anim_lerp_hsv_wrap(&from[f], &to[f], u);
+        }
+        anim_lerp_levels(from_lvl, to_lvl, out, LED_PWM_FIXTURES * 3, u);
+        uint32_t t2 = perf_cycles();
+
+        cyc_hsv += t1 - t0;
+        cyc_rgb += t2 - t1;
+    }
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Кадр перехода, %u фикстур(ы), %u кадров:\n",
+                    LED_PWM_FIXTURES, BENCH_FADE_FRAMES);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  hsv: %lu тактов/кадр\n", (unsigned long)(cyc_hsv / BENCH_FADE_FRAMES));
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  rgb: %lu тактов/кадр\n", (unsigned long)(cyc_rgb / BENCH_FADE_FRAMES));
+}
+#endif
+
 static void cmd_help(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
     (void)argc;
     (void)argv;
     
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Список команд:\n");
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  RGB <r> <g> <b>   - Устанавливает цвет согласно цветовой модели RGB (0-255)\n");
-    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  HSV <h> <s> <v>   - Устанавливает цвет согласно цветовой модели HSV (H:0-360, S:0-100, V:0-100)\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  HSV <h> <s> <v>   - Устанавливает цвет согласно цветовой модели HSV (H:0-360, можно 120.5, S:0-100, V:0-100)\n");
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  STATUS            - Показывает текущий статус цвета\n");
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  RESET             - Сбрасывает цвет согласно варианту #6577\n");
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  HELP              - Показывает информацию о доступных командах\n");
@@ -418,12 +1239,47 @@ static void cmd_help(nrf_cli_t const * p_cli, size_t argc, char ** argv) {
         "  apply_color <name>                 - Применяет выбранный цвет\n");
     nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
         "  list_colors                        - Список сохранённых цветов\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  curve [linear|gamma2|cie]          - Кривая яркости перед ШИМ\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  render_stats                       - Счётчики отрисовки и пропущенных кадров\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  fade [<ms> [hsv|rgb]]              - Плавный переход к новому цвету\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  effect <name> [period=ms h= s= v= duty= min= steps=] | stop - Встроенный эффект\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  hold [accel <delay_ms> <ramp_ms> <max_x> | fine on|off] - Разгон при удержании кнопки\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  scene add <name> <hold_ms> <fade_ms> | clear | loop on|off | list | play | stop - Сцена из палитры\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  flash_stats                        - Записи и стирания flash\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  save                               - Записать отложенные правки во flash сейчас\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  power_stats                        - Пробуждения ядра и прерывания RTC в секунду\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  fixture <n> <h> <s> <v> | <n> common - Свой цвет фикстуры или общий\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  anim hue <ms> | fade <n1> <n2> <ms> | stop - Анимация силами ШИМ/PPI без ядра\n");
+#if LED_STRIP_ENABLED
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  strip <h> <s> <v> [count]          - Залить адресную ленту цветом\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  strip_bench                        - Кадры/с ленты для 60/300/1000 пикселей\n");
+#endif
+#if COLOR_BENCH_ENABLED
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  bench_color                        - Замер тактов HSV->RGB (int/float) и RGB->HSV\n");
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL,
+        "  bench_fade                         - Замер тактов на кадр перехода (hsv/rgb)\n");
+#endif
 }
 
 NRF_CLI_CMD_REGISTER(RGB, NULL, "Set RGB color", cmd_rgb);
 NRF_CLI_CMD_REGISTER(HSV, NULL, "Set HSV color", cmd_hsv);
 NRF_CLI_CMD_REGISTER(STATUS, NULL, "Show current status", cmd_status);
 NRF_CLI_CMD_REGISTER(RESET, NULL, "Reset to default color", cmd_reset);
+NRF_CLI_CMD_REGISTER(save, NULL, "Flush pending changes to flash", cmd_save);
 NRF_CLI_CMD_REGISTER(HELP, NULL, "Show help", cmd_help);
 NRF_CLI_CMD_REGISTER(add_hsv_color, NULL, "Add HSV color", cmd_add_hsv);
 NRF_CLI_CMD_REGISTER(add_current_color, NULL, "Save current color", cmd_add_current);
@@ -431,6 +1287,24 @@ NRF_CLI_CMD_REGISTER(apply_color, NULL, "Apply saved color", cmd_apply_color);
 NRF_CLI_CMD_REGISTER(list_colors, NULL, "List saved colors", cmd_list_colors);
 NRF_CLI_CMD_REGISTER(del_color, NULL, "Delete color", cmd_del_color);
 NRF_CLI_CMD_REGISTER(add_rgb_color, NULL, "Add RGB color", cmd_add_rgb);
+NRF_CLI_CMD_REGISTER(curve, NULL, "Select brightness curve", cmd_curve);
+NRF_CLI_CMD_REGISTER(render_stats, NULL, "Show render counters", cmd_render_stats);
+NRF_CLI_CMD_REGISTER(fade, NULL, "Color transition time", cmd_fade);
+NRF_CLI_CMD_REGISTER(effect, NULL, "Built-in effects", cmd_effect);
+NRF_CLI_CMD_REGISTER(scene, NULL, "Palette scene sequencer", cmd_scene);
+NRF_CLI_CMD_REGISTER(hold, NULL, "Hold acceleration profile", cmd_hold);
+NRF_CLI_CMD_REGISTER(flash_stats, NULL, "Show flash wear counters", cmd_flash_stats);
+NRF_CLI_CMD_REGISTER(power_stats, NULL, "Show wakeup rates", cmd_power_stats);
+NRF_CLI_CMD_REGISTER(fixture, NULL, "Per-fixture color", cmd_fixture);
+NRF_CLI_CMD_REGISTER(anim, NULL, "Hardware-stepped animation", cmd_anim);
+#if LED_STRIP_ENABLED
+NRF_CLI_CMD_REGISTER(strip, NULL, "Fill addressable strip", cmd_strip);
+NRF_CLI_CMD_REGISTER(strip_bench, NULL, "Benchmark strip output", cmd_strip_bench);
+#endif
+#if COLOR_BENCH_ENABLED
+NRF_CLI_CMD_REGISTER(bench_color, NULL, "Benchmark HSV->RGB", cmd_bench_color);
+NRF_CLI_CMD_REGISTER(bench_fade, NULL, "Benchmark fade frame", cmd_bench_fade);
+#endif
 
 static void usbd_user_ev_handler(app_usbd_event_type_t event) {
     switch (event)
@@ -487,7 +1361,7 @@ void set_hsv_color(uint16_t h, uint8_t s, uint8_t v) {
 }
 
 void save_settings(void) {
-    cmd_save(&m_cli_cdc_acm, 1, NULL);
+    persist_flush();
 }
 
 void load_settings(void) {
@@ -495,7 +1369,7 @@ void load_settings(void) {
 }
 
 void get_status(uint16_t *h, uint8_t *s, uint8_t *v, uint8_t *r, uint8_t *g, uint8_t *b) {
-    if (h) *h = (uint16_t)m_h;
+    if (h) *h = COLOR_HUE_TO_DEG(m_h);
     if (s) *s = (uint8_t)m_s;
     if (v) *v = (uint8_t)m_v;
     
@@ -531,27 +1405,96 @@ void usb_cli_init(void) {
 
 void usb_cli_process(void) {
     nrf_cli_process(&m_cli_cdc_acm);
+#if LED_STRIP_ENABLED
+    strip_process();
+#endif
+}
+
+static bool palette_get(void *p_context, uint16_t key, uint32_t *p_words) {
+    (void)p_context;
+    color_entry_t const *p = &m_colors[key];
+    if (!p->used) return false;
+
+    memcpy(p_words, p->name, COLOR_NAME_LEN);
+    p_words[PALETTE_WORDS - 1] = p->h | ((uint32_t)p->s << 16) | ((uint32_t)p->v << 24);
+    return true;
+}
+
+static void palette_apply(void *p_context, uint16_t key, uint32_t const *p_words) {
+    (void)p_context;
+    color_entry_t *p = &m_colors[key];
+    if (p_words == NULL) {
+        p->used = false;
+        return;
+    }
+
+    memcpy(p->name, p_words, COLOR_NAME_LEN);
+    p->h = (uint16_t)p_words[PALETTE_WORDS - 1];
+    p->s = (uint8_t)(p_words[PALETTE_WORDS - 1] >> 16);
+    p->v = (uint8_t)(p_words[PALETTE_WORDS - 1] >> 24);
+    p->used = true;
+}
+
+// Правка слота - одна запись в журнале (удаление - одно слово). Стирание
+// страницы - только при уплотнении, раз на ~160 правок; пишет очередь NVM.
+// Несколько правок слота до записи дают одну запись
+static void palette_flush(void) {
+    uint32_t words[PALETTE_WORDS];
+
+    for (uint16_t i = 0; i < MAX_COLORS; i++) {
+        if (!(m_palette_dirty & (1U << i))) continue;
+        if (palette_get(NULL, i, words)) {
+            kvlog_put(&m_palette_log, i, words);
+        } else {
+            kvlog_del(&m_palette_log, i);
+        }
+    }
+    m_palette_dirty = 0;
+}
+
+static void palette_changed(int idx) {
+    m_palette_dirty |= 1U << idx;
+    persist_mark(PERSIST_PALETTE);
 }
 
-void save_colors_to_flash(void) {
-    flash_colors_t data;
-    data.magic = COLORS_MAGIC;
-    memcpy(data.colors, m_colors, sizeof(m_colors));
+// Старая страница палитры: метка формата, слоты и стёртый остаток.
+// Занятый слот проверяется по диапазонам, флаг занятости - 0 или 1
+static bool legacy_colors_valid(flash_colors_t const *p) {
+    bool deg = (p->magic == COLORS_MAGIC_DEG);
+
+    if (!deg && p->magic != COLORS_MAGIC) return false;
+    for (int i = 0; i < MAX_COLORS; i++) {
+        color_entry_t const *c = &p->colors[i];
+        uint8_t used = *(uint8_t const *)&c->used;
 
-    nrfx_nvmc_page_erase(COLORS_FLASH_ADDR);
-    nrfx_nvmc_words_write(COLORS_FLASH_ADDR,
-        (uint32_t *)&data,
-        sizeof(data) / 4);
+        if (used > 1) return false;
+        if (used && (c->s > 100 || c->v > 100 || (deg && c->h > 360))) return false;
+    }
+    return legacy_tail_erased(COLORS_FLASH_ADDR, sizeof(*p));
 }
 
 void load_colors_from_flash(void) {
     flash_colors_t *p =
         (flash_colors_t *)COLORS_FLASH_ADDR;
 
-    if (p->magic != COLORS_MAGIC)
-        return;
+    kvlog_init(&m_palette_log, nvm_async(), PALETTE_LOG_ADDR, NVM_PAGE_SIZE,
+               PALETTE_WORDS, MAX_COLORS, palette_get, NULL);
+    persist_register(PERSIST_PALETTE, palette_flush, PALETTE_FLUSH_OPS);
+    if (!kvlog_mount(&m_palette_log, palette_apply, NULL) && legacy_colors_valid(p)) {
+        memcpy(m_colors, p->colors, sizeof(m_colors));
+        for (int i = 0; p->magic == COLORS_MAGIC_DEG && i < MAX_COLORS; i++) {
+            m_colors[i].h = COLOR_HUE_FROM_DEG(m_colors[i].h);
+        }
+        // Сразу переносим в журнал под CRC, не дожидаясь первой правки
+        m_palette_dirty = (1U << MAX_COLORS) - 1;
+        persist_mark(PERSIST_PALETTE);
+    }
+
+    load_scene_from_flash();
+}
 
-    memcpy(m_colors, p->colors, sizeof(m_colors));
+void palette_log_stats_get(kvlog_stats_t *p_stats) {
+    *p_stats = m_palette_log.stats;
 }
 
 
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "kvlog.h"
 
 #define MAX_COLORS 10
 #define COLOR_NAME_LEN 16
@@ -20,11 +21,11 @@ void usb_cli_process(void);
 
 void set_rgb_color(uint8_t r, uint8_t g, uint8_t b);
 void set_hsv_color(uint16_t h, uint8_t s, uint8_t v);
-void save_settings(void); // Пока не работает
+void save_settings(void); // Записать отложенные правки сразу
 void load_settings(void); // Пока не работает
 void get_status(uint16_t *h, uint8_t *s, uint8_t *v, uint8_t *r, uint8_t *g, uint8_t *b);
 
-void save_colors_to_flash(void);
 void load_colors_from_flash(void);
+void palette_log_stats_get(kvlog_stats_t *p_stats);
 
 #endif
\ No newline at end of file
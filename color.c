@@ -0,0 +1,352 @@
+#include "color.h"
+
+#include <stdbool.h>
+
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+#include "nrf.h"
+#define COLOR_USE_DSP 1
+#else
+#define COLOR_USE_DSP 0
+#endif
+
+#define COLOR_HALF (COLOR_ONE >> 1)
+
+static inline uint16_t level_to_duty(uint32_t level, uint16_t top) {
+    return (uint16_t)((level * top + COLOR_HALF) >> COLOR_Q);
+}
+
+static inline uint32_t curve_index(uint32_t level) {
+    return (level + 8) >> (COLOR_Q - 10);
+}
+
+static inline uint16_t curve_to_duty(const uint16_t *curve, uint32_t level, uint16_t top) {
+    uint32_t y = curve[curve_index(level)];
+    return (uint16_t)((y * top + 0x8000) >> 16);
+}
+
+// Таблицы строятся препроцессором: LUT_REPn(E, k) разворачивается в E(k) ... E(k + n - 1)
+#define LUT_REP2(E, k)    E(k)                 E((k) + 1)
+#define LUT_REP4(E, k)    LUT_REP2(E, k)       LUT_REP2(E, (k) + 2)
+#define LUT_REP8(E, k)    LUT_REP4(E, k)       LUT_REP4(E, (k) + 4)
+#define LUT_REP16(E, k)   LUT_REP8(E, k)       LUT_REP8(E, (k) + 8)
+#define LUT_REP32(E, k)   LUT_REP16(E, k)      LUT_REP16(E, (k) + 16)
+#define LUT_REP64(E, k)   LUT_REP32(E, k)      LUT_REP32(E, (k) + 32)
+#define LUT_REP128(E, k)  LUT_REP64(E, k)      LUT_REP64(E, (k) + 64)
+#define LUT_REP256(E, k)  LUT_REP128(E, k)     LUT_REP128(E, (k) + 128)
+#define LUT_REP512(E, k)  LUT_REP256(E, k)     LUT_REP256(E, (k) + 256)
+#define LUT_REP1024(E, k) LUT_REP512(E, k)     LUT_REP512(E, (k) + 512)
+#define LUT_REP2048(E, k) LUT_REP1024(E, k)    LUT_REP1024(E, (k) + 1024)
+#define LUT_REP4096(E, k) LUT_REP2048(E, k)    LUT_REP2048(E, (k) + 2048)
+
+#define LUT_REP_(n)  LUT_REP##n
+#define LUT_REP(n)   LUT_REP_(n)
+
+// Кривые яркости: индекс - линейный уровень с шагом COLOR_ONE/1024, значение - 0..65535
+#define CURVE_SIZE   1025
+#define CURVE_MAX    65535ULL
+
+#define CURVE_GAMMA2(k) ((uint16_t)((CURVE_MAX * (k) * (k) + (1ULL << 19)) >> 20)),
+
+// CIE 1931: L = 100k/1024; Y = L/903.3 при L <= 8, иначе ((L + 16)/116)^3
+#define CIE_N(k)     (100ULL * (k) + 16384ULL)
+#define CIE_D        118784ULL
+#define CURVE_CIE(k) ((uint16_t)((100ULL * (k) <= 8192ULL)                                          \
+                        ? (CURVE_MAX * 1000ULL * (k) + 4624896ULL) / 9249792ULL                     \
+                        : ((CIE_N(k) * CIE_N(k) * CIE_N(k) / CIE_D) * CURVE_MAX + CIE_D * CIE_D / 2) \
+                          / (CIE_D * CIE_D))),
+
+static const uint16_t m_curve_gamma2[CURVE_SIZE] = {
+    LUT_REP1024(CURVE_GAMMA2, 0)
+    CURVE_GAMMA2(1024)
+};
+
+static const uint16_t m_curve_cie[CURVE_SIZE] = {
+    LUT_REP1024(CURVE_CIE, 0)
+    CURVE_CIE(1024)
+};
+
+static const uint16_t * const m_curves[COLOR_CURVE_COUNT] = {
+    [COLOR_CURVE_LINEAR] = NULL,
+    [COLOR_CURVE_GAMMA2] = m_curve_gamma2,
+    [COLOR_CURVE_CIE]    = m_curve_cie,
+};
+
+static const char * const m_curve_names[COLOR_CURVE_COUNT] = {
+    [COLOR_CURVE_LINEAR] = "linear",
+    [COLOR_CURVE_GAMMA2] = "gamma2",
+    [COLOR_CURVE_CIE]    = "cie",
+};
+
+static volatile color_curve_t m_curve = COLOR_CURVE_DEFAULT;
+
+#if COLOR_HUE_LUT_BITS
+
+#define HUE_LUT_SIZE (1L << COLOR_HUE_LUT_BITS)
+
+// Вес канала при V=S=1 в точке k таблицы, x = 6k/N - позиция в секторах:
+// R = |x-3|-1, G = 2-|x-2|, B = 2-|x-4|. В таблице веса хранятся без
+// ограничения 0..1 (только до -0.5..1.5, чтобы влезть в int16): тогда
+// между соседними точками они линейны - изломы уходят за ограничение,
+// которое делается уже после интерполяции, и точность от размера
+// таблицы не зависит
+#define HUE_ABS(x)   ((x) < 0 ? -(x) : (x))
+#define HUE_SAT(x)   ((x) < -HUE_LUT_SIZE / 2 ? -HUE_LUT_SIZE / 2 \
+                      : ((x) > 3 * HUE_LUT_SIZE / 2 ? 3 * HUE_LUT_SIZE / 2 : (x)))
+#define HUE_X(k)     (6L * (k))
+#define HUE_WR(k)    HUE_SAT(HUE_ABS(HUE_X(k) - 3 * HUE_LUT_SIZE) - HUE_LUT_SIZE)
+#define HUE_WG(k)    HUE_SAT(2 * HUE_LUT_SIZE - HUE_ABS(HUE_X(k) - 2 * HUE_LUT_SIZE))
+#define HUE_WB(k)    HUE_SAT(2 * HUE_LUT_SIZE - HUE_ABS(HUE_X(k) - 4 * HUE_LUT_SIZE))
+#define HUE_TO_Q(w)  ((int16_t)((w) * (long)COLOR_ONE / HUE_LUT_SIZE))
+
+#define HUE_ENTRY(k) { HUE_TO_Q(HUE_WR(k)), HUE_TO_Q(HUE_WG(k)), HUE_TO_Q(HUE_WB(k)) },
+
+#if   COLOR_HUE_LUT_BITS == 6
+#define HUE_LUT_ENTRIES 64
+#elif COLOR_HUE_LUT_BITS == 7
+#define HUE_LUT_ENTRIES 128
+#elif COLOR_HUE_LUT_BITS == 8
+#define HUE_LUT_ENTRIES 256
+#elif COLOR_HUE_LUT_BITS == 9
+#define HUE_LUT_ENTRIES 512
+#elif COLOR_HUE_LUT_BITS == 10
+#define HUE_LUT_ENTRIES 1024
+#elif COLOR_HUE_LUT_BITS == 11
+#define HUE_LUT_ENTRIES 2048
+#else
+#define HUE_LUT_ENTRIES 4096
+#endif
+
+#define HUE_FRAC_BITS (16 - COLOR_HUE_LUT_BITS)
+
+// Последняя точка повторяет первую: интерполяция не заворачивает индекс
+static const int16_t m_hue_lut[HUE_LUT_SIZE + 1][3] = {
+    LUT_REP(HUE_LUT_ENTRIES)(HUE_ENTRY, 0)
+    HUE_ENTRY(HUE_LUT_SIZE)
+};
+
+static inline void hue_weights(uint16_t hue, uint32_t w[3]) {
+    uint32_t idx = (uint32_t)hue >> HUE_FRAC_BITS;
+    int32_t frac = (int32_t)(hue & ((1UL << HUE_FRAC_BITS) - 1));
+    const int16_t *e0 = m_hue_lut[idx];
+    const int16_t *e1 = m_hue_lut[idx + 1];
+
+    for (int c = 0; c < 3; c++) {
+        int32_t x = e0[c] + (((e1[c] - e0[c]) * frac + (1L << (HUE_FRAC_BITS - 1))) >> HUE_FRAC_BITS);
+        w[c] = (x < 0) ? 0 : ((x > (int32_t)COLOR_ONE) ? COLOR_ONE : (uint32_t)x);
+    }
+}
+
+#else
+
+enum { LVL_V, LVL_P, LVL_Q, LVL_T };
+
+// Какой из уровней V/p/q/t попадает в R, G, B для каждого сектора по 60 градусов
+static const uint8_t m_sector_map[6][3] = {
+    { LVL_V, LVL_T, LVL_P },
+    { LVL_Q, LVL_V, LVL_P },
+    { LVL_P, LVL_V, LVL_T },
+    { LVL_P, LVL_Q, LVL_V },
+    { LVL_T, LVL_P, LVL_V },
+    { LVL_V, LVL_P, LVL_Q },
+};
+
+static inline void hue_weights(uint16_t hue, uint32_t w[3]) {
+    uint32_t x = (uint32_t)hue * 6;
+    uint32_t sector = x >> 16;
+    uint32_t f = (x & 0xFFFF) >> (16 - COLOR_Q);
+
+    uint32_t lvl[4];
+    lvl[LVL_V] = COLOR_ONE;
+    lvl[LVL_P] = 0;
+    lvl[LVL_Q] = COLOR_ONE - f;
+    lvl[LVL_T] = f;
+
+    const uint8_t *map = m_sector_map[sector];
+    w[0] = lvl[map[0]];
+    w[1] = lvl[map[1]];
+    w[2] = lvl[map[2]];
+}
+
+#endif
+
+// Линейные уровни каналов в Q14
+static inline void hsv_to_levels(uint16_t hue, uint8_t s, uint8_t v, uint32_t level[3]) {
+    if (s > 100) s = 100;
+    if (v > 100) v = 100;
+
+    uint32_t vq = ((uint32_t)v * COLOR_ONE + 50) / 100;
+    uint32_t sq = ((uint32_t)s * COLOR_ONE + 50) / 100;
+
+    // Канал = p + span*w: p = V*(1-S), span = V*S, w - вес канала для оттенка
+    uint32_t p = (vq * (COLOR_ONE - sq) + COLOR_HALF) >> COLOR_Q;
+    uint32_t span = vq - p;
+
+    uint32_t w[3];
+    hue_weights(hue, w);
+
+#if COLOR_USE_DSP
+    // Все величины <= COLOR_ONE и помещаются в int16: p*ONE + span*w за одну SMLAD
+    uint32_t ps = __PKHBT(p, span, 16);
+    for (int c = 0; c < 3; c++) {
+        level[c] = __SMLAD(ps, __PKHBT(COLOR_ONE, w[c], 16), COLOR_HALF) >> COLOR_Q;
+    }
+#else
+    for (int c = 0; c < 3; c++) {
+        level[c] = p + ((span * w[c] + COLOR_HALF) >> COLOR_Q);
+    }
+#endif
+}
+
+void color_hsv_to_rgb(uint16_t hue, uint8_t s, uint8_t v, uint16_t top,
+                      uint16_t *r, uint16_t *g, uint16_t *b) {
+    uint32_t level[3];
+    hsv_to_levels(hue, s, v, level);
+    *r = level_to_duty(level[0], top);
+    *g = level_to_duty(level[1], top);
+    *b = level_to_duty(level[2], top);
+}
+
+void color_hsv_to_rgb_batch(color_hsv_t const * p_in, size_t count, uint16_t top,
+                            uint16_t * p_out, size_t stride) {
+    const uint16_t *curve = m_curves[m_curve];
+    uint32_t level[3];
+    for (size_t i = 0; i < count; i++) {
+        hsv_to_levels(p_in[i].h, p_in[i].s, p_in[i].v, level);
+        for (int c = 0; c < 3; c++) {
+            p_out[c] = curve ? curve_to_duty(curve, level[c], top) : level_to_duty(level[c], top);
+        }
+        p_out += stride;
+    }
+}
+
+void color_hsv_to_level16_batch(color_hsv_t const * p_in, size_t count,
+                                uint16_t * p_out, size_t stride) {
+    const uint16_t *curve = m_curves[m_curve];
+    uint32_t level[3];
+    for (size_t i = 0; i < count; i++) {
+        hsv_to_levels(p_in[i].h, p_in[i].s, p_in[i].v, level);
+        for (int c = 0; c < 3; c++) {
+            p_out[c] = curve ? curve[curve_index(level[c])]
+                             : (uint16_t)((level[c] * 0xFFFF + COLOR_HALF) >> COLOR_Q);
+        }
+        p_out += stride;
+    }
+}
+
+void color_curve_set(color_curve_t curve) {
+    if (curve < COLOR_CURVE_COUNT) m_curve = curve;
+}
+
+color_curve_t color_curve_get(void) {
+    return m_curve;
+}
+
+const char * color_curve_name(color_curve_t curve) {
+    return curve < COLOR_CURVE_COUNT ? m_curve_names[curve] : "?";
+}
+
+void color_rgb_to_hsv(uint8_t r, uint8_t g, uint8_t b, color_hsv_t * p_hsv) {
+    uint32_t max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    uint32_t min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    uint32_t delta = max - min;
+
+    uint32_t v = (max * 100 + 127) / 255;
+    p_hsv->v = (uint8_t)v;
+
+    // S считается от уже округлённого V, а не от max: тогда обратное
+    // преобразование даёт тот же min и повторный цикл не уводит цвет
+    int32_t v255 = (int32_t)v * 255;
+    int32_t s;
+    if (v255)
+        s = ((v255 - 100 * (int32_t)min) * 100 + v255 / 2) / v255;
+    else
+        s = max ? (delta * 100 + max / 2) / max : 0;
+    if (s < 0) s = 0;
+    p_hsv->s = (uint8_t)s;
+
+    if (delta == 0) {
+        p_hsv->h = 0;
+        return;
+    }
+
+    // Доля оттенка внутри сектора тоже считается относительно p и span,
+    // восстановленных из округлённых S и V (в сотых долях отсчёта).
+    // Если после округления цвет стал серым - берём исходные min и delta
+    int32_t p = (v255 * (100 - s) + 50) / 100;
+    int32_t span = v255 - p;
+    if (span <= 0) {
+        p = (int32_t)min * 100;
+        span = (int32_t)delta * 100;
+    }
+
+    uint32_t mid, base;
+    bool rising;
+    if (max == r) {
+        rising = g >= b;
+        mid = rising ? g : b;
+        base = rising ? 0 : 6;
+    } else if (max == g) {
+        rising = b >= r;
+        mid = rising ? b : r;
+        base = 2;
+    } else {
+        rising = r >= g;
+        mid = rising ? r : g;
+        base = 4;
+    }
+
+    int32_t num = (int32_t)mid * 100 - p;
+    if (num < 0) num = 0;
+    if (num > span) num = span;
+
+    uint32_t frac = ((uint32_t)num * COLOR_HUE_TURN + 3 * (uint32_t)span) / (6 * (uint32_t)span);
+    uint32_t hue = base * COLOR_HUE_TURN / 6;
+    hue = rising ? hue + frac : hue - frac;
+    p_hsv->h = (uint16_t)hue;
+}
+
+#if COLOR_BENCH_ENABLED
+#include <math.h>
+
+static inline int clamp_int(int v, int lo, int hi) {
+    if (v < lo) return lo;
+    if (v > hi) return hi;
+    return v;
+}
+
+void color_hsv_to_rgb_ref(float h, int s, int v, uint16_t top,
+                          uint16_t *r, uint16_t *g, uint16_t *b) {
+    float H = h;
+    float S = s / 100.0f;
+    float V = v / 100.0f;
+
+    if (S <= 0.0f) {
+        uint16_t val = (uint16_t)(V * top + 0.5f);
+        *r = *g = *b = val;
+        return;
+    }
+
+    if (H >= 360.0f) H = 0.0f;
+    float hf = H / 60.0f;
+    int i = (int)floorf(hf);
+    float f = hf - i;
+    float p = V * (1.0f - S);
+    float q = V * (1.0f - S * f);
+    float t = V * (1.0f - S * (1.0f - f));
+
+    float rf=0, gf=0, bf=0;
+    switch (i) {
+        case 0: rf = V; gf = t; bf = p; break;
+        case 1: rf = q; gf = V; bf = p; break;
+        case 2: rf = p; gf = V; bf = t; break;
+        case 3: rf = p; gf = q; bf = V; break;
+        case 4: rf = t; gf = p; bf = V; break;
+        case 5:
+        default: rf = V; gf = p; bf = q; break;
+    }
+
+    *r = (uint16_t)(clamp_int((int)roundf(rf * top), 0, top));
+    *g = (uint16_t)(clamp_int((int)roundf(gf * top), 0, top));
+    *b = (uint16_t)(clamp_int((int)roundf(bf * top), 0, top));
+}
+#endif
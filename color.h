@@ -0,0 +1,72 @@
+#ifndef COLOR_H
+#define COLOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Оттенок задаётся углом: полный оборот = COLOR_HUE_TURN (360 градусов)
+#define COLOR_HUE_TURN 65536UL
+// Внутренние уровни каналов в формате Q14 (COLOR_ONE = 1.0)
+#define COLOR_Q        14
+#define COLOR_ONE      (1UL << COLOR_Q)
+
+// Таблица оттенков во flash: 2^COLOR_HUE_LUT_BITS + 1 записей на оборот по 6 байт
+// (12 бит - 24 КБ, 6 бит - 390 байт). Между точками вес интерполируется,
+// и погрешность ±1 при top=1000 от размера не зависит - он задаёт только
+// занятый flash. 0 - без таблицы, сектора считаются арифметикой
+#ifndef COLOR_HUE_LUT_BITS
+#define COLOR_HUE_LUT_BITS 6
+#endif
+
+#if COLOR_HUE_LUT_BITS != 0 && (COLOR_HUE_LUT_BITS < 6 || COLOR_HUE_LUT_BITS > 12)
+#error "COLOR_HUE_LUT_BITS: 0 или 6..12"
+#endif
+
+#define COLOR_HUE_FROM_DEG(deg) ((uint16_t)(((uint32_t)(deg) * COLOR_HUE_TURN + 180) / 360))
+#define COLOR_HUE_TO_DEG(hue)   ((uint16_t)(((uint32_t)(hue) * 360 + COLOR_HUE_TURN / 2) / COLOR_HUE_TURN))
+
+// Кривая яркости перед ШИМ: линейная, квадратичная гамма или CIE L*
+typedef enum {
+    COLOR_CURVE_LINEAR = 0,
+    COLOR_CURVE_GAMMA2,
+    COLOR_CURVE_CIE,
+    COLOR_CURVE_COUNT
+} color_curve_t;
+
+#ifndef COLOR_CURVE_DEFAULT
+#define COLOR_CURVE_DEFAULT COLOR_CURVE_LINEAR
+#endif
+
+typedef struct {
+    uint16_t h;   // угол, COLOR_HUE_TURN на оборот
+    uint8_t  s;   // 0-100
+    uint8_t  v;   // 0-100
+} color_hsv_t;
+
+// Целочисленное HSV -> RGB. s, v: 0-100, результат: 0..top
+void color_hsv_to_rgb(uint16_t hue, uint8_t s, uint8_t v, uint16_t top,
+                      uint16_t *r, uint16_t *g, uint16_t *b);
+
+// Пакетное HSV -> ШИМ: для i-го цвета R, G, B пишутся в p_out[i*stride + 0..2].
+// stride в элементах uint16_t, например 4 для nrf_pwm_values_individual_t начиная с channel_1.
+// Применяет текущую кривую яркости (color_curve_set), color_hsv_to_rgb - всегда линейно
+void color_hsv_to_rgb_batch(color_hsv_t const * p_in, size_t count, uint16_t top,
+                            uint16_t * p_out, size_t stride);
+
+// То же, но результат - целевой уровень 0..65535 для вывода с дизерингом
+void color_hsv_to_level16_batch(color_hsv_t const * p_in, size_t count,
+                                uint16_t * p_out, size_t stride);
+
+void color_curve_set(color_curve_t curve);
+color_curve_t color_curve_get(void);
+const char * color_curve_name(color_curve_t curve);
+
+void color_rgb_to_hsv(uint8_t r, uint8_t g, uint8_t b, color_hsv_t * p_hsv);
+
+#if COLOR_BENCH_ENABLED
+// Исходная float-версия, оставлена только для сравнения в bench_color
+void color_hsv_to_rgb_ref(float h, int s, int v, uint16_t top,
+                          uint16_t *r, uint16_t *g, uint16_t *b);
+#endif
+
+#endif
@@ -0,0 +1,20 @@
+#include "crc32.h"
+
+// CRC-32 (IEEE) по полубайтам: таблица на 16 слов вместо 256
+static const uint32_t m_crc_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t crc32_words(uint32_t crc, uint32_t const *p_words, uint32_t count) {
+    crc = ~crc;
+    for (uint32_t i = 0; i < count; i++) {
+        crc ^= p_words[i];
+        for (uint32_t k = 0; k < 8; k++) {
+            crc = (crc >> 4) ^ m_crc_nibble[crc & 0x0F];
+        }
+    }
+    return ~crc;
+}
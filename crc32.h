@@ -0,0 +1,10 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+
+// CRC-32 (IEEE) по словам flash. Продолжение подсчёта - передать прошлый
+// результат в crc, начало - 0
+uint32_t crc32_words(uint32_t crc, uint32_t const * p_words, uint32_t count);
+
+#endif
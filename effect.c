@@ -0,0 +1,180 @@
+#include "effect.h"
+#include <string.h>
+
+#define U_ONE 65536U
+
+static char const * const m_names[EFFECT_COUNT] = {
+    [EFFECT_RAINBOW] = "rainbow",
+    [EFFECT_BREATHE] = "breathe",
+    [EFFECT_STROBE]  = "strobe",
+    [EFFECT_CANDLE]  = "candle",
+    [EFFECT_CYCLE]   = "color-cycle",
+};
+
+// Четверть синуса на 64 шага, 0..65535
+static const uint16_t m_sin_q[65] = {
+        0,  1608,  3216,  4821,  6424,  8022,  9616, 11204,
+    12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586,
+    25079, 26557, 28020, 29465, 30893, 32302, 33692, 35061,
+    36409, 37736, 39039, 40319, 41575, 42806, 44011, 45189,
+    46340, 47464, 48558, 49624, 50659, 51664, 52638, 53580,
+    54490, 55367, 56211, 57021, 57797, 58537, 59243, 59913,
+    60546, 61144, 61704, 62227, 62713, 63161, 63571, 63943,
+    64276, 64570, 64826, 65042, 65219, 65357, 65456, 65515,
+    65535,
+};
+
+// (1 + sin) / 2 в 0..65535, фаза - 65536 на оборот
+static uint16_t wave_sin(uint16_t phase) {
+    uint32_t quarter = phase >> 14;
+    uint32_t x = phase & 0x3FFF;
+    if (quarter & 1) x = 0x4000 - x;
+
+    uint32_t i = x >> 8;
+    uint32_t s = m_sin_q[64];
+    if (i < 64) {
+        s = m_sin_q[i] + (((m_sin_q[i + 1] - m_sin_q[i]) * (x & 0xFF)) >> 8);
+    }
+    return (quarter < 2) ? (uint16_t)(32768 + s / 2) : (uint16_t)(32767 - s / 2);
+}
+
+static uint32_t rng_next(uint32_t *p_state) {
+    uint32_t x = *p_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *p_state = x;
+    return x;
+}
+
+// Фаза t внутри периода, 65536 на период
+static uint16_t period_phase(uint32_t t, uint32_t period_ms) {
+    return (uint16_t)(((uint64_t)(t % period_ms) << 16) / period_ms);
+}
+
+void effect_defaults(effect_id_t id, effect_params_t *p_params) {
+    p_params->duty = 10;
+    p_params->min_v = 0;
+    p_params->steps = 6;
+    switch (id) {
+        case EFFECT_RAINBOW: p_params->period_ms = 5000; break;
+        case EFFECT_BREATHE: p_params->period_ms = 4000; break;
+        case EFFECT_STROBE:  p_params->period_ms = 200; break;
+        case EFFECT_CYCLE:   p_params->period_ms = 12000; break;
+        default:             p_params->period_ms = 0; break;
+    }
+}
+
+void effect_start(effect_t *p_effect, effect_id_t id, effect_params_t const *p_params,
+                  uint32_t now_ms) {
+    p_effect->id = id;
+    p_effect->params = *p_params;
+    if (p_effect->params.period_ms == 0) p_effect->params.period_ms = 1;
+    if (p_effect->params.duty > 100) p_effect->params.duty = 100;
+    if (p_effect->params.steps < 2) p_effect->params.steps = 2;
+    if (p_effect->params.steps > EFFECT_CYCLE_MAX_STEPS) p_effect->params.steps = EFFECT_CYCLE_MAX_STEPS;
+    p_effect->t0_ms = now_ms;
+    p_effect->rng = now_ms | 1;
+    for (uint32_t i = 0; i < EFFECT_MAX_OUTPUTS; i++) {
+        p_effect->flicker[i] = 55000;
+    }
+}
+
+uint32_t effect_render(effect_t *p_effect, uint32_t now_ms,
+                       color_hsv_t *p_out, uint32_t count) {
+    effect_params_t const *p = &p_effect->params;
+    uint32_t t = now_ms - p_effect->t0_ms;
+    uint32_t next = EFFECT_FRAME_MS;
+
+    if (count > EFFECT_MAX_OUTPUTS) count = EFFECT_MAX_OUTPUTS;
+
+    switch (p_effect->id) {
+        case EFFECT_RAINBOW: {
+            uint16_t h = (uint16_t)(p->hsv.h + period_phase(t, p->period_ms));
+            for (uint32_t i = 0; i < count; i++) {
+                p_out[i] = p->hsv;
+                p_out[i].h = (uint16_t)(h + i * COLOR_HUE_TURN / count);
+            }
+            break;
+        }
+
+        case EFFECT_BREATHE: {
+            // Начинаем со дна волны
+            uint16_t w = wave_sin((uint16_t)(period_phase(t, p->period_ms) - 16384));
+            int32_t lo = (p->min_v < p->hsv.v) ? p->min_v : p->hsv.v;
+            uint8_t v = (uint8_t)(lo + (((p->hsv.v - lo) * (int32_t)w + 32768) >> 16));
+            for (uint32_t i = 0; i < count; i++) {
+                p_out[i] = p->hsv;
+                p_out[i].v = v;
+            }
+            break;
+        }
+
+        case EFFECT_STROBE: {
+            uint32_t on_ms = p->period_ms * p->duty / 100;
+            uint32_t pos = t % p->period_ms;
+            bool on = pos < on_ms;
+            for (uint32_t i = 0; i < count; i++) {
+                p_out[i] = p->hsv;
+                if (!on) p_out[i].v = 0;
+            }
+            next = on ? on_ms - pos : p->period_ms - pos;
+            break;
+        }
+
+        case EFFECT_CANDLE: {
+            // Шум 60..100% яркости через фильтр первого порядка, оттенок
+            // гуляет на пару градусов
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t r = rng_next(&p_effect->rng);
+                int32_t target = 39321 + (int32_t)(r % 26215);
+                int32_t f = p_effect->flicker[i];
+                f += (target - f) / 4;
+                p_effect->flicker[i] = (uint16_t)f;
+
+                p_out[i] = p->hsv;
+                p_out[i].v = (uint8_t)((p->hsv.v * (uint32_t)f + 32768) >> 16);
+                p_out[i].h = (uint16_t)(p->hsv.h + (int32_t)((r >> 16) & 0x3FF) - 512);
+            }
+            next = EFFECT_CANDLE_FRAME_MS;
+            break;
+        }
+
+        case EFFECT_CYCLE: {
+            // Половину шага держим цвет, половину плавно (smoothstep) идём
+            // к следующему, всегда вперёд по кругу
+            uint32_t step_turn = COLOR_HUE_TURN / p->steps;
+            uint32_t seg_ms = p->period_ms / p->steps;
+            if (seg_ms == 0) seg_ms = 1;
+            uint32_t pos = t % (seg_ms * p->steps);
+            uint32_t k = pos / seg_ms;
+            uint32_t u = (uint32_t)(((uint64_t)(pos - k * seg_ms) << 16) / seg_ms);
+            u = (u < U_ONE / 2) ? 0 : (u - U_ONE / 2) * 2;
+            u = (uint32_t)(((uint64_t)u * u * (3 * U_ONE - 2 * u)) >> 32);
+
+            uint16_t h = (uint16_t)(p->hsv.h + k * step_turn + ((step_turn * u) >> 16));
+            for (uint32_t i = 0; i < count; i++) {
+                p_out[i] = p->hsv;
+                p_out[i].h = h;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return next ? next : 1;
+}
+
+char const *effect_name(effect_id_t id) {
+    return (id < EFFECT_COUNT) ? m_names[id] : "none";
+}
+
+effect_id_t effect_find(char const *p_name) {
+    effect_id_t id;
+    for (id = 0; id < EFFECT_COUNT; id++) {
+        if (strcmp(p_name, m_names[id]) == 0) break;
+    }
+    return id;
+}
@@ -0,0 +1,57 @@
+#ifndef EFFECT_H
+#define EFFECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "color.h"
+
+// Встроенные эффекты: цвет каждого выхода считается по прошедшему времени
+// в фиксированной точке, формы волн - из таблиц. Модуль не зависит от SDK
+
+#define EFFECT_MAX_OUTPUTS 4
+#define EFFECT_CYCLE_MAX_STEPS 12
+// Шаг кадров у плавных эффектов
+#define EFFECT_FRAME_MS 20
+#define EFFECT_CANDLE_FRAME_MS 40
+
+typedef enum {
+    EFFECT_RAINBOW,          // вращение оттенка, выходы сдвинуты по кругу
+    EFFECT_BREATHE,          // яркость по синусу между min и V
+    EFFECT_STROBE,           // вспышки с заданной скважностью
+    EFFECT_CANDLE,           // случайное мерцание пламени
+    EFFECT_CYCLE,            // steps цветов по кругу с плавными переходами
+    EFFECT_COUNT
+} effect_id_t;
+
+typedef struct {
+    uint32_t    period_ms;   // период эффекта (candle - не используется)
+    color_hsv_t hsv;         // базовый цвет
+    uint8_t     duty;        // strobe: доля включения, %
+    uint8_t     min_v;       // breathe: нижний уровень V
+    uint8_t     steps;       // cycle: число цветов
+} effect_params_t;
+
+typedef struct {
+    effect_id_t     id;
+    effect_params_t params;
+    uint32_t        t0_ms;
+    uint32_t        rng;
+    uint16_t        flicker[EFFECT_MAX_OUTPUTS];   // candle: сглаженный шум, доли 65535
+} effect_t;
+
+// Параметры по умолчанию для эффекта id; базовый цвет не трогает
+void effect_defaults(effect_id_t id, effect_params_t * p_params);
+
+void effect_start(effect_t * p_effect, effect_id_t id, effect_params_t const * p_params,
+                  uint32_t now_ms);
+
+// Цвета count выходов на момент now_ms. Возвращает, через сколько мс
+// нужен следующий кадр (у strobe - до ближайшего фронта)
+uint32_t effect_render(effect_t * p_effect, uint32_t now_ms,
+                       color_hsv_t * p_out, uint32_t count);
+
+char const * effect_name(effect_id_t id);
+// EFFECT_COUNT, если имя неизвестно
+effect_id_t effect_find(char const * p_name);
+
+#endif
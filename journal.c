@@ -0,0 +1,189 @@
+#include "journal.h"
+#include "crc32.h"
+
+// Заголовок страницы: метка, номер страницы в кольце и CRC-32 обоих. Метка
+// пишется последней, поэтому страница с оборванным заголовком не считается.
+// Стирание оборванное на середине оставляет метку, но поднимает биты номера;
+// такую страницу отсекают CRC и метка, обнулённая перед стиранием
+#define JOURNAL_MAGIC 0x4A524E4CU
+
+enum {
+    HDR_MAGIC,
+    HDR_SEQ,
+    HDR_CRC,
+    HDR_WORDS
+};
+
+#define HEADER_BYTES (HDR_WORDS * sizeof(uint32_t))
+
+static uint32_t page_addr(journal_t const *p_journal, uint16_t page) {
+    return p_journal->base + (uint32_t)page * p_journal->page_size;
+}
+
+static uint32_t record_addr(journal_t const *p_journal, uint16_t page, uint16_t slot) {
+    return page_addr(p_journal, page) + HEADER_BYTES +
+           (uint32_t)slot * (p_journal->words + 1U) * sizeof(uint32_t);
+}
+
+static uint32_t rd(journal_t *p_journal, uint32_t addr) {
+    p_journal->stats.mount_reads++;
+    return p_journal->p_nvm->read(addr);
+}
+
+// Номер страницы с целым заголовком; false - страница не в кольце
+static bool header_read(journal_t *p_journal, uint16_t page, uint32_t *p_seq) {
+    uint32_t addr = page_addr(p_journal, page);
+    uint32_t hdr[HDR_WORDS];
+
+    hdr[HDR_MAGIC] = rd(p_journal, addr);
+    if (hdr[HDR_MAGIC] != JOURNAL_MAGIC) return false;
+    hdr[HDR_SEQ] = rd(p_journal, addr + HDR_SEQ * sizeof(uint32_t));
+    hdr[HDR_CRC] = rd(p_journal, addr + HDR_CRC * sizeof(uint32_t));
+    if (crc32_words(0, hdr, HDR_CRC) != hdr[HDR_CRC]) return false;
+    // Страница p получает номера p, p + pages, ...: чужой номер - не наш заголовок
+    if (hdr[HDR_SEQ] % p_journal->pages != page) return false;
+
+    *p_seq = hdr[HDR_SEQ];
+    return true;
+}
+
+// Проверочное слово идёт первым: по нему видно, занята ли запись, а
+// оборванные данные не сойдутся с ним. Стёртым оно не бывает
+static uint32_t record_check(uint32_t const *p_words, uint16_t count) {
+    uint32_t c = 0x4A0C5EEDU;
+    for (uint16_t i = 0; i < count; i++) {
+        c = ((c << 5) | (c >> 27)) ^ p_words[i];
+        c *= 0x9E3779B1U;
+    }
+    return (c == JOURNAL_ERASED) ? 0 : c;
+}
+
+static bool record_valid(journal_t *p_journal, uint32_t addr) {
+    uint32_t words[JOURNAL_MAX_WORDS];
+    uint32_t check = rd(p_journal, addr);
+
+    if (check == JOURNAL_ERASED) return false;
+    for (uint16_t i = 0; i < p_journal->words; i++) {
+        words[i] = rd(p_journal, addr + sizeof(uint32_t) * (i + 1U));
+    }
+    return record_check(words, p_journal->words) == check;
+}
+
+// Занятые записи идут сплошным началом страницы: двоичный поиск первой
+// свободной
+static uint16_t used_slots(journal_t *p_journal, uint16_t page) {
+    uint16_t lo = 0;
+    uint16_t hi = p_journal->slots;
+    while (lo < hi) {
+        uint16_t mid = (uint16_t)((lo + hi) / 2);
+        if (rd(p_journal, record_addr(p_journal, page, mid)) != JOURNAL_ERASED) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Оборванной может быть только последняя запись, так что назад идём
+// от силы на шаг
+static uint32_t latest_in_page(journal_t *p_journal, uint16_t page, uint16_t used) {
+    while (used > 0) {
+        uint32_t addr = record_addr(p_journal, page, --used);
+        if (record_valid(p_journal, addr)) return addr;
+    }
+    return 0;
+}
+
+void journal_init(journal_t *p_journal, journal_nvm_t const *p_nvm, uint32_t base,
+                  uint16_t pages, uint32_t page_size, uint16_t words) {
+    if (words > JOURNAL_MAX_WORDS) words = JOURNAL_MAX_WORDS;
+
+    p_journal->p_nvm = p_nvm;
+    p_journal->base = base;
+    p_journal->page_size = page_size;
+    p_journal->pages = pages;
+    p_journal->words = words;
+    p_journal->slots = (uint16_t)((page_size - HEADER_BYTES) / ((words + 1U) * sizeof(uint32_t)));
+    p_journal->page = -1;
+    p_journal->seq = 0;
+    p_journal->slot = 0;
+    p_journal->latest = 0;
+    p_journal->stats = (journal_stats_t){ 0 };
+}
+
+bool journal_mount(journal_t *p_journal) {
+    int16_t best = -1;
+    uint32_t best_seq = 0;
+
+    p_journal->stats.mount_reads = 0;
+    p_journal->page = -1;
+    p_journal->latest = 0;
+
+    // Страниц в кольце единицы: новейшую ищем перебором заголовков
+    for (uint16_t p = 0; p < p_journal->pages; p++) {
+        uint32_t seq;
+        if (!header_read(p_journal, p, &seq)) continue;
+        if (best < 0 || (int32_t)(seq - best_seq) > 0) {
+            best = (int16_t)p;
+            best_seq = seq;
+        }
+    }
+    if (best < 0) return false;
+
+    p_journal->page = best;
+    p_journal->seq = best_seq;
+    p_journal->slot = used_slots(p_journal, (uint16_t)best);
+    p_journal->latest = latest_in_page(p_journal, (uint16_t)best, p_journal->slot);
+
+    // Запись оборвалась сразу после смены страницы: целая осталась в
+    // предыдущей, её стирание ещё не наступило
+    if (p_journal->latest == 0 && p_journal->pages > 1) {
+        uint16_t prev = (uint16_t)((best + p_journal->pages - 1) % p_journal->pages);
+        uint32_t seq;
+        if (header_read(p_journal, prev, &seq) && seq == best_seq - 1) {
+            p_journal->latest = latest_in_page(p_journal, prev, used_slots(p_journal, prev));
+        }
+    }
+    return p_journal->latest != 0;
+}
+
+bool journal_read(journal_t const *p_journal, uint32_t *p_words) {
+    if (p_journal->latest == 0) return false;
+
+    for (uint16_t i = 0; i < p_journal->words; i++) {
+        p_words[i] = p_journal->p_nvm->read(p_journal->latest + sizeof(uint32_t) * (i + 1U));
+    }
+    return true;
+}
+
+void journal_append(journal_t *p_journal, uint32_t const *p_words) {
+    journal_nvm_t const *nvm = p_journal->p_nvm;
+
+    if (p_journal->page < 0 || p_journal->slot >= p_journal->slots) {
+        uint16_t next = (p_journal->page < 0) ? 0 : (uint16_t)((p_journal->page + 1) % p_journal->pages);
+        uint32_t addr = page_addr(p_journal, next);
+        uint32_t hdr[HDR_WORDS] = {
+            [HDR_MAGIC] = JOURNAL_MAGIC,
+            [HDR_SEQ]   = (p_journal->page < 0) ? 0 : p_journal->seq + 1,
+        };
+        hdr[HDR_CRC] = crc32_words(0, hdr, HDR_CRC);
+
+        // Страница перестаёт быть частью кольца до начала стирания
+        nvm->write(addr + HDR_MAGIC * sizeof(uint32_t), 0);
+        nvm->erase(addr);
+        p_journal->stats.erases++;
+        nvm->write(addr + HDR_SEQ * sizeof(uint32_t), hdr[HDR_SEQ]);
+        nvm->write(addr + HDR_CRC * sizeof(uint32_t), hdr[HDR_CRC]);
+        nvm->write(addr + HDR_MAGIC * sizeof(uint32_t), JOURNAL_MAGIC);
+        p_journal->page = (int16_t)next;
+        p_journal->seq = hdr[HDR_SEQ];
+        p_journal->slot = 0;
+    }
+
+    uint32_t addr = record_addr(p_journal, (uint16_t)p_journal->page, p_journal->slot);
+    nvm->write(addr, record_check(p_words, p_journal->words));
+    for (uint16_t i = 0; i < p_journal->words; i++) {
+        nvm->write(addr + sizeof(uint32_t) * (i + 1U), p_words[i]);
+    }
+    p_journal->slot++;
+    p_journal->latest = addr;
+    p_journal->stats.appends++;
+}
@@ -0,0 +1,58 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Журнал записей фиксированного размера в кольце страниц flash. Записи
+// только дописываются; страница стирается, лишь когда кольцо дошло до неё
+// снова. При загрузке последняя страница находится по номеру в заголовке,
+// последняя запись в ней - двоичным поиском. Доступ к flash - через
+// journal_nvm_t, так что модуль проверяется и на ПК с имитацией NVMC
+
+#define JOURNAL_ERASED 0xFFFFFFFFU
+#define JOURNAL_MAX_WORDS 8
+
+// Операций flash на journal_append в худшем случае (со сменой страницы):
+// обнуление метки, стирание, три слова заголовка и запись
+#define JOURNAL_APPEND_OPS(words) (5U + (words) + 1U)
+
+typedef struct {
+    uint32_t (*read)(uint32_t addr);
+    void     (*write)(uint32_t addr, uint32_t value);
+    void     (*erase)(uint32_t page_addr);
+} journal_nvm_t;
+
+typedef struct {
+    uint32_t appends;
+    uint32_t erases;
+    uint32_t mount_reads;    // чтений слов при последнем journal_mount
+} journal_stats_t;
+
+typedef struct {
+    journal_nvm_t const * p_nvm;
+    uint32_t base;           // адрес первой страницы кольца
+    uint32_t page_size;
+    uint16_t pages;
+    uint16_t words;          // слов данных в записи, до JOURNAL_MAX_WORDS
+    uint16_t slots;          // записей на страницу
+    int16_t  page;           // активная страница, -1 - журнал пуст
+    uint32_t seq;            // номер активной страницы
+    uint16_t slot;           // следующая свободная запись в активной странице
+    uint32_t latest;         // адрес последней целой записи, 0 - нет
+    journal_stats_t stats;
+} journal_t;
+
+void journal_init(journal_t * p_journal, journal_nvm_t const * p_nvm, uint32_t base,
+                  uint16_t pages, uint32_t page_size, uint16_t words);
+
+// Поиск последней записи. true - есть целая запись
+bool journal_mount(journal_t * p_journal);
+
+// Данные последней целой записи; false - журнал пуст
+bool journal_read(journal_t const * p_journal, uint32_t * p_words);
+
+// Дописывает запись; при заполненной странице стирает следующую в кольце
+void journal_append(journal_t * p_journal, uint32_t const * p_words);
+
+#endif
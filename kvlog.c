@@ -0,0 +1,199 @@
+#include "kvlog.h"
+#include <stddef.h>
+#include "crc32.h"
+
+// Заголовок страницы: метка, номер и CRC-32 обоих. Снимок пишется раньше
+// заголовка, метка - последней, так что страница с оборванным снимком не
+// считается. Перед стиранием метка обнуляется, а оборванное стирание,
+// поднявшее биты номера при целой метке, отсекает CRC
+#define KVLOG_MAGIC 0x4B564C47U
+
+enum {
+    HDR_MAGIC,
+    HDR_SEQ,
+    HDR_CRC,
+    HDR_WORDS
+};
+
+#define HEADER_BYTES (HDR_WORDS * sizeof(uint32_t))
+
+// Первое слово записи: тип, ключ и 16 бит проверки. Оно пишется после
+// данных, поэтому запись с ним целиком на месте. Стёртым не бывает
+#define TAG_PUT 0xA5U
+#define TAG_DEL 0x5AU
+
+static uint32_t page_addr(kvlog_t const *p_log, uint16_t page) {
+    return p_log->base + (uint32_t)page * p_log->page_size;
+}
+
+static uint32_t record_addr(kvlog_t const *p_log, uint16_t page, uint16_t slot) {
+    return page_addr(p_log, page) + HEADER_BYTES +
+           (uint32_t)slot * (p_log->words + 1U) * sizeof(uint32_t);
+}
+
+static uint32_t rd(kvlog_t *p_log, uint32_t addr) {
+    p_log->stats.mount_reads++;
+    return p_log->p_nvm->read(addr);
+}
+
+static void wr(kvlog_t *p_log, uint32_t addr, uint32_t value) {
+    p_log->stats.words++;
+    p_log->p_nvm->write(addr, value);
+}
+
+// Номер страницы с целым заголовком; false - страница не в журнале
+static bool header_read(kvlog_t *p_log, uint16_t page, uint32_t *p_seq) {
+    uint32_t addr = page_addr(p_log, page);
+    uint32_t hdr[HDR_WORDS];
+
+    hdr[HDR_MAGIC] = rd(p_log, addr);
+    if (hdr[HDR_MAGIC] != KVLOG_MAGIC) return false;
+    hdr[HDR_SEQ] = rd(p_log, addr + HDR_SEQ * sizeof(uint32_t));
+    hdr[HDR_CRC] = rd(p_log, addr + HDR_CRC * sizeof(uint32_t));
+    if (crc32_words(0, hdr, HDR_CRC) != hdr[HDR_CRC]) return false;
+    // Страницы чередуются: номер страницы p всегда даёт остаток p
+    if (hdr[HDR_SEQ] % KVLOG_PAGES != page) return false;
+
+    *p_seq = hdr[HDR_SEQ];
+    return true;
+}
+
+static uint32_t record_head(uint32_t tag, uint16_t key, uint32_t const *p_words, uint16_t count) {
+    uint32_t c = 0x6B7F1A05U ^ (tag << 8) ^ key;
+    for (uint16_t i = 0; i < count; i++) {
+        c = ((c << 5) | (c >> 27)) ^ p_words[i];
+        c *= 0x9E3779B1U;
+    }
+    return (tag << 24) | ((uint32_t)(key & 0xFF) << 16) | ((c ^ (c >> 16)) & 0xFFFFU);
+}
+
+static void record_write(kvlog_t *p_log, uint16_t slot, uint32_t tag, uint16_t key,
+                         uint32_t const *p_words) {
+    uint32_t addr = record_addr(p_log, (uint16_t)p_log->page, slot);
+    uint16_t count = (tag == TAG_PUT) ? p_log->words : 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        wr(p_log, addr + sizeof(uint32_t) * (i + 1U), p_words[i]);
+    }
+    wr(p_log, addr, record_head(tag, key, p_words, count));
+}
+
+void kvlog_init(kvlog_t *p_log, journal_nvm_t const *p_nvm, uint32_t base,
+                uint32_t page_size, uint16_t words, uint16_t keys,
+                kvlog_get_t get, void *p_context) {
+    if (words > KVLOG_MAX_WORDS) words = KVLOG_MAX_WORDS;
+    if (keys > KVLOG_MAX_KEYS) keys = KVLOG_MAX_KEYS;
+
+    p_log->p_nvm = p_nvm;
+    p_log->base = base;
+    p_log->page_size = page_size;
+    p_log->words = words;
+    p_log->keys = keys;
+    p_log->slots = (uint16_t)((page_size - HEADER_BYTES) / ((words + 1U) * sizeof(uint32_t)));
+    p_log->page = -1;
+    p_log->seq = 0;
+    p_log->slot = 0;
+    p_log->get = get;
+    p_log->p_context = p_context;
+    p_log->stats = (kvlog_stats_t){ 0 };
+}
+
+bool kvlog_mount(kvlog_t *p_log, kvlog_apply_t apply, void *p_context) {
+    int16_t best = -1;
+    uint32_t best_seq = 0;
+
+    p_log->stats.mount_reads = 0;
+    p_log->page = -1;
+    p_log->slot = 0;
+
+    for (uint16_t p = 0; p < KVLOG_PAGES; p++) {
+        uint32_t seq;
+        if (!header_read(p_log, p, &seq)) continue;
+        if (best < 0 || (int32_t)(seq - best_seq) > 0) {
+            best = (int16_t)p;
+            best_seq = seq;
+        }
+    }
+    if (best < 0) return false;
+
+    p_log->page = best;
+    p_log->seq = best_seq;
+
+    uint32_t words[KVLOG_MAX_WORDS];
+    uint16_t slot;
+    for (slot = 0; slot < p_log->slots; slot++) {
+        uint32_t addr = record_addr(p_log, (uint16_t)best, slot);
+        uint32_t head = rd(p_log, addr);
+        bool blank = (head == JOURNAL_ERASED);
+
+        for (uint16_t i = 0; i < p_log->words; i++) {
+            words[i] = rd(p_log, addr + sizeof(uint32_t) * (i + 1U));
+            if (words[i] != JOURNAL_ERASED) blank = false;
+        }
+        // Первая чистая запись - конец журнала. Запись без заголовка, но
+        // с данными оборвалась: пропускаем, писать в неё уже нельзя
+        if (blank) break;
+        if (head == JOURNAL_ERASED) continue;
+
+        uint32_t tag = head >> 24;
+        uint16_t key = (uint16_t)((head >> 16) & 0xFF);
+        if (key >= p_log->keys) continue;
+        if (tag == TAG_PUT && head == record_head(TAG_PUT, key, words, p_log->words)) {
+            apply(p_context, key, words);
+        } else if (tag == TAG_DEL && head == record_head(TAG_DEL, key, words, 0)) {
+            apply(p_context, key, NULL);
+        }
+    }
+    p_log->slot = slot;
+    return true;
+}
+
+void kvlog_compact(kvlog_t *p_log) {
+    uint16_t next = (p_log->page < 0) ? 0 : (uint16_t)((p_log->page + 1) % KVLOG_PAGES);
+    uint32_t addr = page_addr(p_log, next);
+    uint32_t words[KVLOG_MAX_WORDS];
+    uint16_t slot = 0;
+    uint32_t hdr[HDR_WORDS] = {
+        [HDR_MAGIC] = KVLOG_MAGIC,
+        [HDR_SEQ]   = (p_log->page < 0) ? 0 : p_log->seq + 1,
+    };
+    hdr[HDR_CRC] = crc32_words(0, hdr, HDR_CRC);
+
+    // Страница выходит из журнала до начала стирания
+    wr(p_log, addr + HDR_MAGIC * sizeof(uint32_t), 0);
+    p_log->p_nvm->erase(addr);
+    p_log->stats.erases++;
+    p_log->stats.compactions++;
+
+    p_log->page = (int16_t)next;
+    for (uint16_t key = 0; key < p_log->keys && slot < p_log->slots; key++) {
+        if (p_log->get(p_log->p_context, key, words)) {
+            record_write(p_log, slot++, TAG_PUT, key, words);
+        }
+    }
+    wr(p_log, addr + HDR_SEQ * sizeof(uint32_t), hdr[HDR_SEQ]);
+    wr(p_log, addr + HDR_CRC * sizeof(uint32_t), hdr[HDR_CRC]);
+    wr(p_log, addr + HDR_MAGIC * sizeof(uint32_t), KVLOG_MAGIC);
+    p_log->seq = hdr[HDR_SEQ];
+    p_log->slot = slot;
+}
+
+static void append(kvlog_t *p_log, uint32_t tag, uint16_t key, uint32_t const *p_words) {
+    if (key >= p_log->keys) return;
+
+    // Места нет: снимок уже содержит эту правку
+    if (p_log->page < 0 || p_log->slot >= p_log->slots) {
+        kvlog_compact(p_log);
+        return;
+    }
+    record_write(p_log, p_log->slot++, tag, key, p_words);
+    p_log->stats.appends++;
+}
+
+void kvlog_put(kvlog_t *p_log, uint16_t key, uint32_t const *p_words) {
+    append(p_log, TAG_PUT, key, p_words);
+}
+
+void kvlog_del(kvlog_t *p_log, uint16_t key) {
+    append(p_log, TAG_DEL, key, NULL);
+}
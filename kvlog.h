@@ -0,0 +1,71 @@
+#ifndef KVLOG_H
+#define KVLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "journal.h"
+
+// Журнал правок набора записей по номерам (ключам) на паре страниц flash.
+// Правка - одна запись в конце страницы: "ключ = данные" или "ключ удалён";
+// удаление стоит одного слова. Текущее состояние - проигрывание журнала
+// при загрузке. Когда страница кончилась, живые записи переписываются
+// снимком на вторую страницу (уплотнение), старая остаётся целой, пока
+// снимок не дописан. Доступ к flash - через journal_nvm_t
+
+#define KVLOG_PAGES 2
+#define KVLOG_MAX_WORDS 8
+#define KVLOG_MAX_KEYS 256
+
+// Операций flash на уплотнение: обнуление метки, стирание, снимок всех
+// ключей и три слова заголовка
+#define KVLOG_COMPACT_OPS(words, keys) (5U + (keys) * ((words) + 1U))
+// ... и на edits правок подряд в худшем случае: страница кончилась на
+// последней, и одно уплотнение. Второго не бывает, пока на странице
+// помещается вдвое больше записей, чем ключей
+#define KVLOG_EDITS_OPS(words, keys, edits) \
+    (((edits) - 1U) * ((words) + 1U) + KVLOG_COMPACT_OPS(words, keys))
+
+// Данные ключа key для снимка при уплотнении; false - ключ пуст
+typedef bool (*kvlog_get_t)(void * p_context, uint16_t key, uint32_t * p_words);
+// Правка из журнала при загрузке; p_words == NULL - ключ удалён
+typedef void (*kvlog_apply_t)(void * p_context, uint16_t key, uint32_t const * p_words);
+
+typedef struct {
+    uint32_t appends;
+    uint32_t erases;
+    uint32_t compactions;
+    uint32_t words;          // записано слов
+    uint32_t mount_reads;    // чтений слов при последнем kvlog_mount
+} kvlog_stats_t;
+
+typedef struct {
+    journal_nvm_t const * p_nvm;
+    uint32_t    base;        // адрес первой из KVLOG_PAGES страниц
+    uint32_t    page_size;
+    uint16_t    words;       // слов данных в записи, до KVLOG_MAX_WORDS
+    uint16_t    keys;        // ключей 0..keys-1, до KVLOG_MAX_KEYS
+    uint16_t    slots;       // записей на страницу
+    int16_t     page;        // активная страница, -1 - журнал пуст
+    uint32_t    seq;         // номер активной страницы
+    uint16_t    slot;        // следующая свободная запись
+    kvlog_get_t get;
+    void *      p_context;
+    kvlog_stats_t stats;
+} kvlog_t;
+
+void kvlog_init(kvlog_t * p_log, journal_nvm_t const * p_nvm, uint32_t base,
+                uint32_t page_size, uint16_t words, uint16_t keys,
+                kvlog_get_t get, void * p_context);
+
+// Проигрывает журнал через apply. false - журнал пуст
+bool kvlog_mount(kvlog_t * p_log, kvlog_apply_t apply, void * p_context);
+
+// Правки. Состояние, которое отдаёт get, должно уже включать правку:
+// при заполненной странице вместо записи делается снимок
+void kvlog_put(kvlog_t * p_log, uint16_t key, uint32_t const * p_words);
+void kvlog_del(kvlog_t * p_log, uint16_t key);
+
+// Снимок живых записей на свободную страницу
+void kvlog_compact(kvlog_t * p_log);
+
+#endif
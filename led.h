@@ -0,0 +1,123 @@
+#ifndef LED_H
+#define LED_H
+
+#include <stdint.h>
+#include "color.h"
+#include "effect.h"
+#include "scene.h"
+#include "journal.h"
+
+// Цвет по умолчанию (вариант #6577): H = 77% оборота, S = V = 100
+#define LED_DEFAULT_H ((uint16_t)(COLOR_HUE_TURN * 77 / 100))
+#define LED_DEFAULT_S 100
+#define LED_DEFAULT_V 100
+
+// Длительность перехода к новому цвету по умолчанию, 0 - мгновенно
+#ifndef LED_FADE_DEFAULT_MS
+#define LED_FADE_DEFAULT_MS 300
+#endif
+
+// Разгон при удержании кнопки: первые delay_ms - базовая скорость
+// (1 градус / 1% за 20 мс), затем за ramp_ms скорость линейно растёт
+// до max_x раз. В точном режиме разгона нет, скорость в LED_HOLD_FINE_DIV
+// раз ниже базовой
+#ifndef LED_HOLD_DELAY_MS
+#define LED_HOLD_DELAY_MS 250
+#endif
+#ifndef LED_HOLD_RAMP_MS
+#define LED_HOLD_RAMP_MS 500
+#endif
+#ifndef LED_HOLD_MAX_X
+#define LED_HOLD_MAX_X 24
+#endif
+#define LED_HOLD_MAX_X_LIMIT 100
+#define LED_HOLD_FINE_DIV 4
+
+typedef struct {
+    uint32_t delay_ms;
+    uint32_t ramp_ms;
+    uint32_t max_x;
+    uint32_t fine;           // 1 - точный режим
+} led_hold_profile_t;
+
+// Пространство интерполяции перехода
+typedef enum {
+    LED_FADE_HSV,            // по кругу оттенков, через пересчёт в уровни
+    LED_FADE_RGB             // по уровням каналов, линейно по свету
+} led_fade_space_t;
+
+typedef struct {
+    uint32_t ticks;          // вызовы шага отрисовки
+    uint32_t converted;      // кадры, где цвет пересчитывался
+    uint32_t written;        // кадры, где обновлялся ШИМ
+    uint32_t convert_cycles; // суммарные такты на пересчёт
+    uint32_t sleeps;         // остановки main_timer: тики больше никому не нужны
+    uint32_t wakes;          // кадры, нарисованные сразу по изменению, вне тика
+    uint32_t wake_cycles;    // такты от изменения до записи кадра (последний раз)
+    uint32_t fade_frames;    // кадры перехода
+    uint32_t fade_cycles;    // суммарные такты на интерполяцию переходов
+} led_render_stats_t;
+
+// Источники спроса на тики main_timer
+typedef enum {
+    LED_TICK_HOLD,           // удержание кнопки в режиме настройки
+    LED_TICK_ANIM,           // программная анимация и переходы
+    LED_TICK_EFFECT,         // эффект или сцена, срок до их следующего кадра
+    LED_TICK_SRC_COUNT
+} led_tick_src_t;
+
+typedef struct {
+    uint32_t wakeups;        // выходы главного цикла из __WFE
+    uint32_t rtc_irqs;       // срабатывания наших app_timer (прерывания RTC1)
+    uint32_t ticks;          // тики main_timer
+    uint32_t tick_ms;        // текущий интервал тиков, 0 - main_timer стоит
+    uint32_t time_ms;        // led_time_ms() на момент снятия
+} led_power_stats_t;
+
+// Сообщает отрисовке, что m_h/m_s/m_v изменились; вне тика кадр рисуется
+// сразу. m_h - угол COLOR_HUE_TURN на оборот
+void led_color_changed(void);
+void led_render_stats_get(led_render_stats_t * p_stats);
+
+// Источнику src нужны тики раз в interval_ms (0 - не нужны). main_timer
+// идёт с минимальным запрошенным интервалом и стоит, если запросов нет
+void led_tick_request(led_tick_src_t src, uint32_t interval_ms);
+void led_power_stats_get(led_power_stats_t * p_stats);
+
+// Монотонное время по RTC0 в мс для анимаций и замеров, идёт и в простое
+uint32_t led_time_ms(void);
+
+// Новый общий цвет с плавным переходом (led_fade_set), без перехода -
+// как запись m_h/m_s/m_v и led_color_changed
+void led_color_set(color_hsv_t const * p_hsv);
+void led_fade_set(uint32_t ms, led_fade_space_t space);
+void led_fade_get(uint32_t * p_ms, led_fade_space_t * p_space);
+
+// Встроенный эффект вместо общего цвета (m_h/m_s/m_v не меняет).
+// Запуск эффекта останавливает сцену
+void led_effect_start(effect_id_t id, effect_params_t const * p_params);
+void led_effect_stop(void);
+// true - эффект идёт, *p_id - какой
+bool led_effect_get(effect_id_t * p_id);
+
+// Сцена вместо общего цвета; p_cues должны жить до led_scene_stop.
+// Запуск сцены останавливает эффект и наоборот
+void led_scene_start(scene_cue_t const * p_cues, uint16_t count, bool loop);
+void led_scene_stop(void);
+// true - сцена идёт, *p_idx - текущий цвет, *p_done - одноразовая доиграла
+bool led_scene_get(uint16_t * p_idx, bool * p_done);
+
+// Профиль удержания; save пишет его на страницу настроек во flash
+void led_hold_profile_set(led_hold_profile_t const * p_profile);
+void led_hold_profile_get(led_hold_profile_t * p_profile);
+void led_hold_profile_save(void);
+
+// Счётчики журнала настроек (HSV и профиль удержания)
+void led_settings_journal_stats_get(journal_stats_t * p_stats);
+// Сколько заняли проверка и загрузка сохранённого при старте
+uint32_t led_flash_load_us(void);
+
+// Свой цвет фикстуры idx (0..LED_PWM_FIXTURES-1); NULL - снова общий m_h/m_s/m_v
+void led_fixture_set(uint8_t idx, color_hsv_t const * p_hsv);
+
+#endif
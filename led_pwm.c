@@ -0,0 +1,700 @@
+#include "led_pwm.h"
+
+#include "nrfx_pwm.h"
+#include "nrfx_ppi.h"
+#include "nrf_rtc.h"
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "perf.h"
+
+#define LED0_PIN 6
+#define LED1_PIN 8
+#define LED2_PIN 41
+#define LED3_PIN 12
+
+#define PWM_INSTANCES 4
+#define FIXTURE_COMPONENTS 4   // R, G, B, W
+
+#define DITHER_FRAMES (1U << LED_PWM_DITHER_BITS)
+
+// Оба слота (SEQ0 и SEQ1) нужно перевести на новый буфер
+#define SLOTS_ALL 0x3U
+
+// Индикатор режима играет свой PWM по кругу без участия ядра. Один шаг формы -
+// период ШИМ (1 мс), длинные формы растягиваются повторами каждого значения
+#define IND_WAVE_LEN 500U
+
+// Аппаратная анимация: RTC2 COMPARE0 -> PPI -> NEXTSTEP всех занятых PWM
+// (+ fork на CLEAR RTC2). RTC2 идёт от LFCLK, так что ядро и HFCLK-таймеры
+// в шаге кадров не участвуют
+#define ANIM_RTC NRF_RTC2
+
+typedef struct {
+    uint8_t instance;   // PWM0..PWM3
+    uint8_t channel;    // 0..3 внутри экземпляра
+    uint8_t pin;        // NRFX_PWM_PIN_NOT_USED - компоненты нет
+} channel_out_t;
+
+#define OUT(i, c, p) { .instance = (i), .channel = (c), .pin = (p) }
+#define OUT_NONE     { .instance = 0, .channel = 0, .pin = NRFX_PWM_PIN_NOT_USED }
+
+// Карта каналов: компонент фикстуры -> экземпляр/канал/вывод.
+// Если у фикстуры есть W, он получает min(R, G, B), а RGB уменьшаются на него
+static const channel_out_t m_channel_map[LED_PWM_FIXTURES][FIXTURE_COMPONENTS] = {
+    // RGB-светодиод платы
+    { OUT(0, 1, LED1_PIN), OUT(0, 2, LED2_PIN), OUT(0, 3, LED3_PIN), OUT_NONE },
+#if LED_PWM_FIXTURES > 1
+    // Внешние RGBW-фикстуры на выводах разъёма
+    { OUT(2, 0, 13), OUT(2, 1, 15), OUT(2, 2, 17), OUT(2, 3, 20) },
+#endif
+#if LED_PWM_FIXTURES > 2
+    { OUT(3, 0, 22), OUT(3, 1, 24), OUT(3, 2, 32), OUT(3, 3, 42) },   // P1.00, P1.10
+#endif
+#if LED_PWM_FIXTURES > 3
+    { OUT(1, 0, 31), OUT(1, 1, 29), OUT(1, 2, 2), OUT(1, 3, 45) },    // P1.13
+#endif
+};
+
+#if LED_PWM_FIXTURES > 3 && LED_PWM_IND_INSTANCE == 1
+#error "Четвёртая фикстура занимает PWM1: задайте LED_PWM_IND_INSTANCE -1"
+#endif
+
+static nrfx_pwm_t const m_pwm[PWM_INSTANCES] = {
+    NRFX_PWM_INSTANCE(0),
+    NRFX_PWM_INSTANCE(1),
+    NRFX_PWM_INSTANCE(2),
+    NRFX_PWM_INSTANCE(3),
+};
+
+// Последовательности экземпляра, занятого фикстурами. Два буфера:
+// EasyDMA читает front, запись идёт в другой. Буфер, на который указывает
+// хотя бы один слот, не трогаем
+typedef struct {
+    nrf_pwm_values_individual_t seq[2][DITHER_FRAMES];
+    nrf_pwm_values_individual_t anim[LED_PWM_ANIM_MAX_FRAMES];
+} pwm_buf_t;
+
+typedef struct {
+    bool used;
+    uint8_t front;
+    volatile uint8_t swap_slots;   // слоты, ещё указывающие на старый буфер
+    nrf_ppi_channel_t anim_ppi;
+    pwm_buf_t *p_buf;
+} pwm_inst_t;
+
+static pwm_inst_t m_inst[PWM_INSTANCES];
+
+// Буферы только под занятые экземпляры: в m_channel_map у каждой фикстуры
+// свой экземпляр, так что их столько же, сколько фикстур
+static pwm_buf_t m_buf[LED_PWM_FIXTURES];
+
+#if LED_PWM_IND_INSTANCE >= 0
+static nrf_pwm_values_common_t m_ind_wave[IND_WAVE_LEN];
+#endif
+
+static volatile bool m_anim;
+static bool m_anim_ppi_ready;
+
+// Экземпляры, у которых переключение ещё не завершено. Кадр применён, когда
+// все они перешли на новый буфер
+static volatile uint8_t m_swapping;
+static uint32_t m_swap_t0;             // такт запроса текущего переключения
+
+// Последний запрос, пришедший во время переключения или остановки
+static volatile bool m_pending;
+static uint32_t m_pending_t0;
+static uint16_t m_pending_levels[LED_PWM_FIXTURES * 3];
+
+// Чёрный статичный вывод: экземпляры фикстур остановлены, выводы в покое
+// (высокий уровень - светодиоды платы выключены), HFCLK им не нужен
+static volatile bool m_suspended;
+
+// Экземпляры, чей STOP ещё не дошёл до конца периода. Остановку заканчивает
+// обработчик STOPPED: ждать её в led_pwm_write() нельзя, оттуда зовут
+// из критической секции
+static volatile uint8_t m_stopping;
+
+static uint16_t const m_black[LED_PWM_FIXTURES * 3];
+
+static led_pwm_stats_t m_stats;
+
+static void seq_play(uint32_t i);
+
+// Порядок периодов, получающих лишний отсчёт: бит-реверс номера,
+// чтобы добавки равномерно распределялись по циклу
+static uint8_t m_dither_rank[DITHER_FRAMES];
+
+static void dither_rank_init(void) {
+    for (uint32_t i = 0; i < DITHER_FRAMES; i++) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < LED_PWM_DITHER_BITS; b++) {
+            if (i & (1U << b)) r |= 1U << (LED_PWM_DITHER_BITS - 1 - b);
+        }
+        m_dither_rank[i] = (uint8_t)r;
+    }
+}
+
+// p_ch - поле канала в первом периоде, следующие через PWM_CHANNELS
+static void dither_channel(uint16_t *p_ch, uint16_t level) {
+    uint32_t total = ((uint32_t)level * PWM_TOP_VALUE + (1U << (15 - LED_PWM_DITHER_BITS)))
+                     >> (16 - LED_PWM_DITHER_BITS);
+    uint32_t base = total >> LED_PWM_DITHER_BITS;
+    uint32_t rem = total & (DITHER_FRAMES - 1);
+
+    for (uint32_t i = 0; i < DITHER_FRAMES; i++) {
+        p_ch[i * PWM_CHANNELS] = (uint16_t)(base + (m_dither_rank[i] < rem));
+    }
+}
+
+static inline uint16_t *channel_ptr(nrf_pwm_values_individual_t *p_values, uint8_t channel) {
+    return (uint16_t *)p_values + channel;
+}
+
+// Уровни компонентов фикстуры с учётом W
+static void fixture_levels(uint32_t f, uint16_t const *p_rgb, uint16_t out[FIXTURE_COMPONENTS]) {
+    uint16_t r = p_rgb[0], g = p_rgb[1], b = p_rgb[2], w = 0;
+
+    if (m_channel_map[f][3].pin != NRFX_PWM_PIN_NOT_USED) {
+        w = r < g ? r : g;
+        if (b < w) w = b;
+        r -= w;
+        g -= w;
+        b -= w;
+    }
+    out[0] = r;
+    out[1] = g;
+    out[2] = b;
+    out[3] = w;
+}
+
+// Заполняет буфер back (или front во время анимации) всех экземпляров
+static void fill_sequences(bool back, uint16_t const *p_levels) {
+    for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+        uint16_t lv[FIXTURE_COMPONENTS];
+        fixture_levels(f, &p_levels[f * 3], lv);
+
+        for (uint32_t c = 0; c < FIXTURE_COMPONENTS; c++) {
+            channel_out_t const *p_out = &m_channel_map[f][c];
+            if (p_out->pin == NRFX_PWM_PIN_NOT_USED) continue;
+
+            pwm_inst_t *p_inst = &m_inst[p_out->instance];
+            uint8_t buf = back ? (p_inst->front ^ 1) : p_inst->front;
+            dither_channel(channel_ptr(p_inst->p_buf->seq[buf], p_out->channel), lv[c]);
+        }
+    }
+}
+
+static inline void seqend_int_enable(uint32_t i, bool enable) {
+    uint32_t mask = NRF_PWM_INT_SEQEND0_MASK | NRF_PWM_INT_SEQEND1_MASK;
+    if (enable) {
+        nrf_pwm_int_enable(m_pwm[i].p_registers, mask);
+    } else {
+        nrf_pwm_int_disable(m_pwm[i].p_registers, mask);
+    }
+}
+
+// Запускает переключение на заполненные задние буферы. SEQEND включаем только
+// на время переключения, чтобы в покое ШИМ не будил ядро каждый цикл
+static void swap_begin(uint32_t t0) {
+    m_swap_t0 = t0;
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (!m_inst[i].used) continue;
+
+        m_inst[i].swap_slots = SLOTS_ALL;
+        m_swapping |= (uint8_t)(1U << i);
+        nrf_pwm_event_clear(m_pwm[i].p_registers, NRF_PWM_EVENT_SEQEND0);
+        nrf_pwm_event_clear(m_pwm[i].p_registers, NRF_PWM_EVENT_SEQEND1);
+        seqend_int_enable(i, true);
+    }
+}
+
+static void swap_done(void) {
+    uint32_t latency = perf_cycles() - m_swap_t0;
+    m_stats.swaps++;
+    m_stats.latency_last = latency;
+    if (latency > m_stats.latency_max) m_stats.latency_max = latency;
+
+    // Старые буферы освободились - сразу берём отложенный запрос
+    if (m_pending) {
+        m_pending = false;
+        m_stats.deferred++;
+        fill_sequences(true, m_pending_levels);
+        swap_begin(m_pending_t0);
+    }
+}
+
+// Экземпляр i остановился. Когда стоят все, front больше никто не читает:
+// при остановке в нём чёрный кадр, а если за время остановки пришёл
+// ненулевой запрос - он и сразу запуск
+static void stop_done(uint32_t i) {
+    CRITICAL_REGION_ENTER();
+    if (m_stopping & (1U << i)) {
+        m_stopping &= (uint8_t)~(1U << i);
+        if (m_stopping == 0) {
+            if (m_suspended) {
+                fill_sequences(false, m_black);
+            } else if (m_pending) {
+                m_pending = false;
+                fill_sequences(false, m_pending_levels);
+                for (uint32_t k = 0; k < PWM_INSTANCES; k++) {
+                    if (m_inst[k].used) seq_play(k);
+                }
+                m_stats.resumes++;
+                m_stats.resume_cycles = perf_cycles() - m_pending_t0;
+            }
+        }
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+// SEQENDn: слот n доиграл, сейчас играет другой - указатель слота n
+// можно менять, он будет прочитан при следующем старте слота
+static void pwm_handler(uint32_t i, nrfx_pwm_evt_type_t event_type) {
+    pwm_inst_t *p_inst = &m_inst[i];
+    uint8_t slot;
+
+    if (event_type == NRFX_PWM_EVT_END_SEQ0) {
+        slot = 0;
+    } else if (event_type == NRFX_PWM_EVT_END_SEQ1) {
+        slot = 1;
+    } else {
+        if (event_type == NRFX_PWM_EVT_STOPPED) stop_done(i);
+        return;
+    }
+
+    if (!(p_inst->swap_slots & (1U << slot))) return;
+
+    nrf_pwm_values_t values = { .p_individual = p_inst->p_buf->seq[p_inst->front ^ 1] };
+    nrfx_pwm_sequence_values_update(&m_pwm[i], slot, values);
+    p_inst->swap_slots &= (uint8_t)~(1U << slot);
+    if (p_inst->swap_slots != 0) return;
+
+    seqend_int_enable(i, false);
+    p_inst->front ^= 1;
+
+    // Обработчики PWM одного приоритета, но led_pwm_write() может прервать
+    CRITICAL_REGION_ENTER();
+    m_swapping &= (uint8_t)~(1U << i);
+    if (m_swapping == 0) {
+        swap_done();
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+static void pwm0_handler(nrfx_pwm_evt_type_t event_type) { pwm_handler(0, event_type); }
+static void pwm1_handler(nrfx_pwm_evt_type_t event_type) { pwm_handler(1, event_type); }
+static void pwm2_handler(nrfx_pwm_evt_type_t event_type) { pwm_handler(2, event_type); }
+static void pwm3_handler(nrfx_pwm_evt_type_t event_type) { pwm_handler(3, event_type); }
+
+static nrfx_pwm_handler_t const m_handlers[PWM_INSTANCES] = {
+    pwm0_handler, pwm1_handler, pwm2_handler, pwm3_handler
+};
+
+// Сбрасывает незавершённое переключение: новейшие данные становятся front.
+// Вызывается в критической секции при остановленном или останавливаемом PWM
+static void swap_abort(void) {
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (!m_inst[i].used) continue;
+        seqend_int_enable(i, false);
+        if (m_inst[i].swap_slots != 0) {
+            m_inst[i].front ^= 1;
+            m_inst[i].swap_slots = 0;
+        }
+    }
+    m_swapping = 0;
+}
+
+static bool levels_zero(uint16_t const *p_levels) {
+    for (uint32_t k = 0; k < LED_PWM_FIXTURES * 3; k++) {
+        if (p_levels[k] != 0) return false;
+    }
+    return true;
+}
+
+// STOP срабатывает в конце текущего периода ШИМ (<= 1 мс): не ждём его,
+// front очистит stop_done()
+static void suspend(void) {
+    CRITICAL_REGION_ENTER();
+    swap_abort();
+    m_pending = false;
+    m_suspended = true;
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (m_inst[i].used) m_stopping |= (uint8_t)(1U << i);
+    }
+    CRITICAL_REGION_EXIT();
+
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        // Уже стоявший экземпляр STOPPED не пришлёт
+        if (m_inst[i].used && nrfx_pwm_stop(&m_pwm[i], false)) stop_done(i);
+    }
+    m_stats.suspends++;
+}
+
+// PWM стоит, так что front можно заполнить на месте и сразу запускать.
+// Если остановка ещё идёт, запрос ждёт её конца в m_pending
+static void resume(uint16_t const *p_levels, uint32_t t0) {
+    bool stopping;
+
+    CRITICAL_REGION_ENTER();
+    m_suspended = false;
+    stopping = m_stopping != 0;
+    if (stopping) {
+        m_pending = true;
+        m_pending_t0 = t0;
+        for (uint32_t k = 0; k < LED_PWM_FIXTURES * 3; k++) {
+            m_pending_levels[k] = p_levels[k];
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (stopping) return;
+
+    fill_sequences(false, p_levels);
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (m_inst[i].used) seq_play(i);
+    }
+    m_stats.resumes++;
+    m_stats.resume_cycles = perf_cycles() - t0;
+}
+
+void led_pwm_write(uint16_t const *p_levels) {
+    uint32_t t0 = perf_cycles();
+    bool busy;
+
+    if (!m_anim) {
+        bool zero = levels_zero(p_levels);
+        if (m_suspended) {
+            if (!zero) resume(p_levels, t0);
+            return;
+        }
+        if (zero) {
+            suspend();
+            return;
+        }
+    }
+
+    CRITICAL_REGION_ENTER();
+    // Во время анимации PWM играют кадры, а front простаивает:
+    // пишем прямо в него, его покажет led_pwm_anim_stop()
+    if (m_anim) {
+        fill_sequences(false, p_levels);
+        busy = true;
+    } else if (m_swapping != 0 || m_stopping != 0) {
+        busy = true;
+        if (m_pending) m_stats.coalesced++;
+        m_pending = true;
+        m_pending_t0 = t0;
+        for (uint32_t k = 0; k < LED_PWM_FIXTURES * 3; k++) {
+            m_pending_levels[k] = p_levels[k];
+        }
+    } else {
+        busy = false;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (busy) return;
+
+    // Задние буферы свободны: ни один слот на них не указывает
+    fill_sequences(true, p_levels);
+
+    CRITICAL_REGION_ENTER();
+    swap_begin(t0);
+    CRITICAL_REGION_EXIT();
+}
+
+// Запуск обычного проигрывания из front (после init и после анимации)
+static void seq_play(uint32_t i) {
+    nrf_pwm_sequence_t seq = {
+        .values.p_individual = m_inst[i].p_buf->seq[m_inst[i].front],
+        .length = PWM_CHANNELS * DITHER_FRAMES,
+        .repeats = 0,
+        .end_delay = 0
+    };
+
+    // Два проигрывания: SEQ0 и SEQ1 чередуются, и SEQEND приходят от обоих
+    // слотов (при одном драйвер крутит только SEQ1). Флаги SIGNAL_END_SEQx нужны,
+    // чтобы драйвер передавал события в обработчик; сами прерывания включаются
+    // только на время переключения буферов.
+    // LOOPSDONE при наличии обработчика будил бы ядро на каждом круге
+    nrfx_pwm_simple_playback(&m_pwm[i], &seq, 2,
+                             NRFX_PWM_FLAG_LOOP |
+                             NRFX_PWM_FLAG_NO_EVT_FINISHED |
+                             NRFX_PWM_FLAG_SIGNAL_END_SEQ0 |
+                             NRFX_PWM_FLAG_SIGNAL_END_SEQ1);
+
+    // Переключение могло начаться до старта - тогда его SEQEND нужны
+    CRITICAL_REGION_ENTER();
+    if (m_inst[i].swap_slots == 0) {
+        seqend_int_enable(i, false);
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+void led_pwm_anim_frame_set(uint16_t idx, uint16_t const *p_levels) {
+    if (m_anim || idx >= LED_PWM_ANIM_MAX_FRAMES) return;
+
+    // Без дизеринга: в пошаговом режиме кадр - одно значение на весь интервал
+    for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+        uint16_t lv[FIXTURE_COMPONENTS];
+        fixture_levels(f, &p_levels[f * 3], lv);
+
+        for (uint32_t c = 0; c < FIXTURE_COMPONENTS; c++) {
+            channel_out_t const *p_out = &m_channel_map[f][c];
+            if (p_out->pin == NRFX_PWM_PIN_NOT_USED) continue;
+
+            *channel_ptr(&m_inst[p_out->instance].p_buf->anim[idx], p_out->channel) =
+                (uint16_t)(((uint32_t)lv[c] * PWM_TOP_VALUE + 0x8000U) >> 16);
+        }
+    }
+}
+
+void led_pwm_anim_start(uint16_t count, uint32_t frame_us) {
+    if (count == 0 || count > LED_PWM_ANIM_MAX_FRAMES) return;
+    if (m_anim) led_pwm_anim_stop();
+
+    uint32_t ticks = (uint32_t)(((uint64_t)frame_us * RTC_INPUT_FREQ + 500000) / 1000000);
+    if (ticks < 2) ticks = 2;
+    if (ticks > RTC_COUNTER_COUNTER_Msk) ticks = RTC_COUNTER_COUNTER_Msk;
+
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (m_inst[i].used) nrfx_pwm_stop(&m_pwm[i], true);
+    }
+
+    // Незавершённое переключение уже не нужно: новейшие данные делаем front.
+    // После анимации front играет всегда, остановку решит следующая запись
+    CRITICAL_REGION_ENTER();
+    swap_abort();
+    // Остановку закончили здесь же: чёрный кадр в front кладём сами
+    if (m_suspended) fill_sequences(false, m_black);
+    m_suspended = false;
+    m_stopping = 0;
+    if (m_pending) {
+        m_pending = false;
+        fill_sequences(false, m_pending_levels);
+    }
+    m_anim = true;
+    CRITICAL_REGION_EXIT();
+
+    // Одно событие RTC раздаётся всем экземплярам, CLEAR - fork первого канала
+    bool first = true;
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (!m_inst[i].used) continue;
+
+        if (!m_anim_ppi_ready) {
+            APP_ERROR_CHECK(nrfx_ppi_channel_alloc(&m_inst[i].anim_ppi));
+        }
+        APP_ERROR_CHECK(nrfx_ppi_channel_assign(m_inst[i].anim_ppi,
+            nrf_rtc_event_address_get(ANIM_RTC, NRF_RTC_EVENT_COMPARE_0),
+            nrfx_pwm_task_address_get(&m_pwm[i], NRF_PWM_TASK_NEXTSTEP)));
+        if (first) {
+            APP_ERROR_CHECK(nrfx_ppi_channel_fork_assign(m_inst[i].anim_ppi,
+                nrf_rtc_task_address_get(ANIM_RTC, NRF_RTC_TASK_CLEAR)));
+            first = false;
+        }
+    }
+    m_anim_ppi_ready = true;
+
+    // Счёт идёт 0..CC, затем CLEAR: кадр длится CC+1 тик
+    nrf_rtc_task_trigger(ANIM_RTC, NRF_RTC_TASK_STOP);
+    nrf_rtc_task_trigger(ANIM_RTC, NRF_RTC_TASK_CLEAR);
+    nrf_rtc_prescaler_set(ANIM_RTC, 0);
+    nrf_rtc_cc_set(ANIM_RTC, 0, ticks - 1);
+    nrf_rtc_event_clear(ANIM_RTC, NRF_RTC_EVENT_COMPARE_0);
+    nrf_rtc_event_enable(ANIM_RTC, NRF_RTC_INT_COMPARE0_MASK);
+
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (!m_inst[i].used) continue;
+
+        nrf_pwm_decoder_set(m_pwm[i].p_registers, NRF_PWM_LOAD_INDIVIDUAL, NRF_PWM_STEP_TRIGGERED);
+        nrf_pwm_sequence_t seq = {
+            .values.p_individual = m_inst[i].p_buf->anim,
+            .length = (uint16_t)(PWM_CHANNELS * count),
+            .repeats = 0,
+            .end_delay = 0
+        };
+        // Без SIGNAL_END_SEQx и с NO_EVT_FINISHED драйвер не включает прерываний
+        nrfx_pwm_simple_playback(&m_pwm[i], &seq, 2,
+                                 NRFX_PWM_FLAG_LOOP | NRFX_PWM_FLAG_NO_EVT_FINISHED);
+        APP_ERROR_CHECK(nrfx_ppi_channel_enable(m_inst[i].anim_ppi));
+    }
+
+    nrf_rtc_task_trigger(ANIM_RTC, NRF_RTC_TASK_START);
+}
+
+void led_pwm_anim_stop(void) {
+    if (!m_anim) return;
+
+    nrf_rtc_task_trigger(ANIM_RTC, NRF_RTC_TASK_STOP);
+    nrf_rtc_event_disable(ANIM_RTC, NRF_RTC_INT_COMPARE0_MASK);
+
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (!m_inst[i].used) continue;
+
+        APP_ERROR_CHECK(nrfx_ppi_channel_disable(m_inst[i].anim_ppi));
+        nrfx_pwm_stop(&m_pwm[i], true);
+        nrf_pwm_decoder_set(m_pwm[i].p_registers, NRF_PWM_LOAD_INDIVIDUAL, NRF_PWM_STEP_AUTO);
+    }
+
+    CRITICAL_REGION_ENTER();
+    m_anim = false;
+    CRITICAL_REGION_EXIT();
+
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (m_inst[i].used) seq_play(i);
+    }
+}
+
+bool led_pwm_anim_active(void) {
+    return m_anim;
+}
+
+bool led_pwm_instance_used(uint8_t instance) {
+    if (instance >= PWM_INSTANCES) return true;
+#if LED_PWM_IND_INSTANCE >= 0
+    if (instance == LED_PWM_IND_INSTANCE) return true;
+#endif
+    return m_inst[instance].used;
+}
+
+void led_pwm_stats_get(led_pwm_stats_t *p_stats) {
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_stats;
+    CRITICAL_REGION_EXIT();
+}
+
+#if LED_PWM_IND_INSTANCE >= 0
+
+static nrfx_pwm_t const *const mp_ind = &m_pwm[LED_PWM_IND_INSTANCE];
+
+// Останавливает индикатор: буфер формы можно менять только после остановки
+static void ind_stop(void) {
+    if (!nrfx_pwm_is_stopped(mp_ind)) {
+        nrfx_pwm_stop(mp_ind, true);
+    }
+}
+
+static void ind_play(uint16_t length, uint32_t repeats) {
+    nrf_pwm_sequence_t seq = {
+        .values.p_common = m_ind_wave,
+        .length = length,
+        .repeats = repeats,
+        .end_delay = 0
+    };
+    nrfx_pwm_simple_playback(mp_ind, &seq, 1, NRFX_PWM_FLAG_LOOP);
+}
+
+void led_pwm_indicator_off(void) {
+    ind_stop();
+}
+
+void led_pwm_indicator_const(uint16_t duty) {
+    ind_stop();
+    m_ind_wave[0] = duty;
+    ind_play(1, 0);
+}
+
+void led_pwm_indicator_breathe(uint32_t period_ms) {
+    uint32_t half = period_ms / 2;
+    if (half == 0) {
+        led_pwm_indicator_const(PWM_TOP_VALUE);
+        return;
+    }
+
+    // Каждое значение играется reps периодов, чтобы форма влезла в буфер
+    uint32_t half_len = IND_WAVE_LEN / 2;
+    uint32_t reps = (half + half_len - 1) / half_len;
+    uint32_t steps = half / reps;
+
+    ind_stop();
+    for (uint32_t i = 0; i < steps; i++) {
+        uint16_t duty = (uint16_t)((i * PWM_TOP_VALUE + steps / 2) / steps);
+        m_ind_wave[i] = duty;
+        m_ind_wave[steps + i] = (uint16_t)(PWM_TOP_VALUE - duty);
+    }
+    ind_play((uint16_t)(2 * steps), reps - 1);
+}
+
+static void ind_init(void) {
+    // Карта каналов не должна занимать экземпляр индикатора
+    for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+        for (uint32_t c = 0; c < FIXTURE_COMPONENTS; c++) {
+            if (m_channel_map[f][c].pin != NRFX_PWM_PIN_NOT_USED &&
+                m_channel_map[f][c].instance == LED_PWM_IND_INSTANCE) {
+                APP_ERROR_CHECK(NRF_ERROR_INVALID_PARAM);
+            }
+        }
+    }
+
+    nrfx_pwm_config_t config = NRFX_PWM_DEFAULT_CONFIG;
+    config.output_pins[0] = LED0_PIN | NRFX_PWM_PIN_INVERTED;
+    config.output_pins[1] = NRFX_PWM_PIN_NOT_USED;
+    config.output_pins[2] = NRFX_PWM_PIN_NOT_USED;
+    config.output_pins[3] = NRFX_PWM_PIN_NOT_USED;
+    config.base_clock = NRF_PWM_CLK_1MHz;
+    config.count_mode = NRF_PWM_MODE_UP;
+    config.top_value  = PWM_TOP_VALUE;
+    config.load_mode  = NRF_PWM_LOAD_COMMON;
+    config.step_mode  = NRF_PWM_STEP_AUTO;
+
+    // Без обработчика драйвер не включает прерывания индикатора вовсе
+    ret_code_t err_code = nrfx_pwm_init(mp_ind, &config, NULL);
+    APP_ERROR_CHECK(err_code);
+}
+
+#else
+
+void led_pwm_indicator_off(void) {}
+void led_pwm_indicator_const(uint16_t duty) { (void)duty; }
+void led_pwm_indicator_breathe(uint32_t period_ms) { (void)period_ms; }
+static void ind_init(void) {}
+
+#endif
+
+void led_pwm_init(void) {
+    nrfx_pwm_config_t config[PWM_INSTANCES];
+
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        nrfx_pwm_config_t def = NRFX_PWM_DEFAULT_CONFIG;
+        config[i] = def;
+        for (uint32_t c = 0; c < PWM_CHANNELS; c++) {
+            config[i].output_pins[c] = NRFX_PWM_PIN_NOT_USED;
+        }
+        config[i].base_clock = NRF_PWM_CLK_1MHz;
+        config[i].count_mode = NRF_PWM_MODE_UP;
+        config[i].top_value  = PWM_TOP_VALUE;
+        config[i].load_mode  = NRF_PWM_LOAD_INDIVIDUAL;
+        config[i].step_mode  = NRF_PWM_STEP_AUTO;
+    }
+
+    for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+        for (uint32_t c = 0; c < FIXTURE_COMPONENTS; c++) {
+            channel_out_t const *p_out = &m_channel_map[f][c];
+            if (p_out->pin == NRFX_PWM_PIN_NOT_USED) continue;
+
+            // Светодиоды включаются низким уровнем: в покое (PWM остановлен)
+            // вывод должен быть высоким
+            config[p_out->instance].output_pins[p_out->channel] = p_out->pin | NRFX_PWM_PIN_INVERTED;
+            m_inst[p_out->instance].used = true;
+        }
+    }
+
+    dither_rank_init();
+
+    uint32_t bufs = 0;
+    for (uint32_t i = 0; i < PWM_INSTANCES; i++) {
+        if (!m_inst[i].used) continue;
+
+        // Карта раскидала фикстуры по большему числу экземпляров, чем буферов
+        if (bufs == LED_PWM_FIXTURES) {
+            APP_ERROR_CHECK(NRF_ERROR_NO_MEM);
+        }
+        m_inst[i].p_buf = &m_buf[bufs++];
+
+        ret_code_t err_code = nrfx_pwm_init(&m_pwm[i], &config[i], m_handlers[i]);
+        APP_ERROR_CHECK(err_code);
+        m_inst[i].front = 0;
+        seq_play(i);
+    }
+
+    ind_init();
+}
@@ -0,0 +1,84 @@
+#ifndef LED_PWM_H
+#define LED_PWM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PWM_CHANNELS 4
+#define PWM_TOP_VALUE 1000U
+
+// Временной дизеринг: целевой уровень 0..65535 раскладывается на 2^LED_PWM_DITHER_BITS
+// периодов ШИМ, которые EasyDMA проигрывает по кругу. При 1 МГц и top=1000 это
+// ~10 + LED_PWM_DITHER_BITS бит при цикле 2^bits мс. 0 - без дизеринга
+#ifndef LED_PWM_DITHER_BITS
+#define LED_PWM_DITHER_BITS 4
+#endif
+
+#if LED_PWM_DITHER_BITS < 0 || LED_PWM_DITHER_BITS > 6
+#error "LED_PWM_DITHER_BITS: 0..6"
+#endif
+
+// Число фикстур RGB(W). Их каналы раскладываются по PWM0..PWM3 таблицей
+// m_channel_map в led_pwm.c, все фикстуры обновляются одним вызовом
+#ifndef LED_PWM_FIXTURES
+#define LED_PWM_FIXTURES 1
+#endif
+
+#if LED_PWM_FIXTURES < 1 || LED_PWM_FIXTURES > 4
+#error "LED_PWM_FIXTURES: 1..4"
+#endif
+
+// Экземпляр PWM под индикатор режима, -1 - без индикатора
+#ifndef LED_PWM_IND_INSTANCE
+#define LED_PWM_IND_INSTANCE 1
+#endif
+
+// Счётчики двойной буферизации. Задержка - такты от led_pwm_write() до момента,
+// когда оба слота последовательности всех экземпляров переведены на новый буфер
+typedef struct {
+    uint32_t swaps;
+    uint32_t deferred;      // запросы, применённые сразу после текущего переключения
+    uint32_t coalesced;     // запросы, перезаписанные более новыми до применения
+    uint32_t latency_last;
+    uint32_t latency_max;
+    uint32_t suspends;      // остановки PWM на чёрном кадре
+    uint32_t resumes;
+    uint32_t resume_cycles; // такты от led_pwm_write() до запуска PWM (последний)
+} led_pwm_stats_t;
+
+void led_pwm_init(void);
+
+// p_levels - LED_PWM_FIXTURES троек RGB, целевые уровни 0..65535.
+// Новые значения попадают в задние буферы и применяются на границе
+// последовательности, поэтому кадр никогда не смешивает старые и новые каналы.
+// Полностью чёрный кадр останавливает PWM фикстур, следующий ненулевой
+// запускает их сразу из front, без ожидания переключения
+void led_pwm_write(uint16_t const * p_levels);
+
+// Индикатор на LED0 (отдельный PWM). Форма считается один раз при вызове
+// и дальше проигрывается аппаратно, ядро для индикатора не просыпается
+void led_pwm_indicator_off(void);
+void led_pwm_indicator_const(uint16_t duty);
+// Треугольник 0..top..0 с периодом period_ms
+void led_pwm_indicator_breathe(uint32_t period_ms);
+
+void led_pwm_stats_get(led_pwm_stats_t * p_stats);
+
+// Занят ли экземпляр PWM фикстурами или индикатором (для других выходов)
+bool led_pwm_instance_used(uint8_t instance);
+
+// Аппаратная анимация на всех занятых PWM: кадры шагают по RTC2 через PPI (NEXTSTEP),
+// ядро может спать. Кадры задаются при остановленной анимации, уровни 0..65535.
+// Пока она идёт, led_pwm_write() только запоминает цвет для led_pwm_anim_stop()
+#ifndef LED_PWM_ANIM_MAX_FRAMES
+#define LED_PWM_ANIM_MAX_FRAMES 256
+#endif
+
+// p_levels - как в led_pwm_write()
+void led_pwm_anim_frame_set(uint16_t idx, uint16_t const * p_levels);
+// frame_us - длительность кадра, округляется до тика LFCLK (~30.5 мкс)
+void led_pwm_anim_start(uint16_t count, uint32_t frame_us);
+void led_pwm_anim_stop(void);
+bool led_pwm_anim_active(void);
+
+#endif
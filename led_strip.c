@@ -0,0 +1,146 @@
+#include "led_strip.h"
+
+#if LED_STRIP_ENABLED
+
+#include <string.h>
+#include "nrfx_pwm.h"
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "led_pwm.h"
+#include "perf.h"
+#include "ws2812.h"
+
+#define FB_BYTES (LED_STRIP_MAX_PIXELS * LED_STRIP_BYTES_PER_PIXEL)
+#define CHUNK_BYTES (LED_STRIP_CHUNK_PIXELS * LED_STRIP_BYTES_PER_PIXEL)
+#define CHUNK_SLOTS (CHUNK_BYTES * WS2812_SLOTS_PER_BYTE)
+
+static nrfx_pwm_t const m_strip_pwm = NRFX_PWM_INSTANCE(LED_STRIP_PWM_INSTANCE);
+
+// Кадровые буферы в порядке передачи (GRB/GRBW): в m_draw рисуют,
+// другой выводится
+static uint8_t m_fb[2][FB_BYTES];
+static uint8_t m_draw;
+
+// Чанки для SEQ0/SEQ1: пока играет один, обработчик дозаполняет другой
+static uint16_t m_chunk[2][CHUNK_SLOTS];
+
+static ws2812_sched_t m_sched;
+static volatile bool m_busy;
+static uint32_t m_show_t0;
+static led_strip_stats_t m_stats;
+
+// SEQENDn: буфер слота n освободился, пока играет другой слот. Если другой
+// слот успел доиграть раньше, чем мы закончили, DMA прочитал старый чанк
+static void strip_handler(nrfx_pwm_evt_type_t event_type) {
+    switch (event_type) {
+        case NRFX_PWM_EVT_END_SEQ0:
+        case NRFX_PWM_EVT_END_SEQ1: {
+            uint32_t slot = (event_type == NRFX_PWM_EVT_END_SEQ0) ? 0 : 1;
+            nrf_pwm_event_t other = slot ? NRF_PWM_EVENT_SEQEND0 : NRF_PWM_EVENT_SEQEND1;
+
+            if (!ws2812_sched_next(&m_sched, m_chunk[slot])) break;
+            if (nrf_pwm_event_check(m_strip_pwm.p_registers, other)) {
+                m_stats.underruns++;
+            }
+            break;
+        }
+
+        case NRFX_PWM_EVT_STOPPED:
+            m_stats.frames++;
+            m_stats.frame_cycles = perf_cycles() - m_show_t0;
+            m_busy = false;
+            break;
+
+        default:
+            break;
+    }
+}
+
+void led_strip_pixel_set(uint16_t idx, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+    if (idx >= LED_STRIP_MAX_PIXELS) return;
+
+    uint8_t *p = &m_fb[m_draw][idx * LED_STRIP_BYTES_PER_PIXEL];
+    p[0] = g;
+    p[1] = r;
+    p[2] = b;
+#if LED_STRIP_BYTES_PER_PIXEL == 4
+    p[3] = w;
+#else
+    (void)w;
+#endif
+}
+
+bool led_strip_show(uint16_t count) {
+    if (count == 0 || count > LED_STRIP_MAX_PIXELS) return false;
+
+    bool busy;
+    CRITICAL_REGION_ENTER();
+    busy = m_busy;
+    m_busy = true;
+    CRITICAL_REGION_EXIT();
+    if (busy) return false;
+
+    uint8_t out = m_draw;
+    m_draw ^= 1;
+    memcpy(m_fb[m_draw], m_fb[out], (size_t)count * LED_STRIP_BYTES_PER_PIXEL);
+
+    m_show_t0 = perf_cycles();
+    uint16_t chunks = ws2812_sched_begin(&m_sched, m_fb[out],
+                                         (uint32_t)count * LED_STRIP_BYTES_PER_PIXEL, CHUNK_BYTES);
+    ws2812_sched_next(&m_sched, m_chunk[0]);
+    ws2812_sched_next(&m_sched, m_chunk[1]);
+
+    nrf_pwm_sequence_t seq0 = {
+        .values.p_common = m_chunk[0],
+        .length = CHUNK_SLOTS,
+        .repeats = 0,
+        .end_delay = 0
+    };
+    nrf_pwm_sequence_t seq1 = seq0;
+    seq1.values.p_common = m_chunk[1];
+
+    // Пары SEQ0+SEQ1 крутятся chunks/2 раз, затем STOP. Между чанками нет
+    // пауз, линия уходит в низкий уровень только хвостом сброса
+    nrfx_pwm_complex_playback(&m_strip_pwm, &seq0, &seq1, chunks / 2,
+                              NRFX_PWM_FLAG_STOP |
+                              NRFX_PWM_FLAG_NO_EVT_FINISHED |
+                              NRFX_PWM_FLAG_SIGNAL_END_SEQ0 |
+                              NRFX_PWM_FLAG_SIGNAL_END_SEQ1);
+    return true;
+}
+
+bool led_strip_busy(void) {
+    return m_busy;
+}
+
+void led_strip_stats_get(led_strip_stats_t *p_stats) {
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_stats;
+    CRITICAL_REGION_EXIT();
+}
+
+void led_strip_init(void) {
+    // Экземпляр не должен пересекаться с фикстурами и индикатором
+    if (led_pwm_instance_used(LED_STRIP_PWM_INSTANCE)) {
+        APP_ERROR_CHECK(NRF_ERROR_INVALID_PARAM);
+    }
+
+    nrfx_pwm_config_t config = NRFX_PWM_DEFAULT_CONFIG;
+    config.output_pins[0] = LED_STRIP_PIN;
+    config.output_pins[1] = NRFX_PWM_PIN_NOT_USED;
+    config.output_pins[2] = NRFX_PWM_PIN_NOT_USED;
+    config.output_pins[3] = NRFX_PWM_PIN_NOT_USED;
+    // Дозаполнение чанка должно успеть за время соседнего (~1 мс),
+    // поэтому приоритет выше таймеров и USB
+    config.irq_priority = APP_IRQ_PRIORITY_HIGH;
+    config.base_clock = NRF_PWM_CLK_16MHz;
+    config.count_mode = NRF_PWM_MODE_UP;
+    config.top_value  = WS2812_PWM_TOP;
+    config.load_mode  = NRF_PWM_LOAD_COMMON;
+    config.step_mode  = NRF_PWM_STEP_AUTO;
+
+    ret_code_t err_code = nrfx_pwm_init(&m_strip_pwm, &config, strip_handler);
+    APP_ERROR_CHECK(err_code);
+}
+
+#endif
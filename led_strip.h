@@ -0,0 +1,62 @@
+#ifndef LED_STRIP_H
+#define LED_STRIP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Адресная лента WS2812/SK6812 на отдельном экземпляре PWM: кадр кодируется
+// в слоты ws2812.c чанками и выдаётся EasyDMA без участия ядра между чанками
+#ifndef LED_STRIP_ENABLED
+#define LED_STRIP_ENABLED 0
+#endif
+
+// 3 - WS2812 (GRB), 4 - SK6812 (GRBW)
+#ifndef LED_STRIP_BYTES_PER_PIXEL
+#define LED_STRIP_BYTES_PER_PIXEL 3
+#endif
+
+#ifndef LED_STRIP_MAX_PIXELS
+#define LED_STRIP_MAX_PIXELS 1000
+#endif
+
+// Пикселей в чанке: 32 пикселя - 0.96 мс на дозаполнение второго буфера
+#ifndef LED_STRIP_CHUNK_PIXELS
+#define LED_STRIP_CHUNK_PIXELS 32
+#endif
+
+#ifndef LED_STRIP_PWM_INSTANCE
+#define LED_STRIP_PWM_INSTANCE 3
+#endif
+
+#ifndef LED_STRIP_PIN
+#define LED_STRIP_PIN 47   // P1.15
+#endif
+
+#if LED_STRIP_BYTES_PER_PIXEL != 3 && LED_STRIP_BYTES_PER_PIXEL != 4
+#error "LED_STRIP_BYTES_PER_PIXEL: 3 или 4"
+#endif
+
+typedef struct {
+    uint32_t frames;        // выданные кадры
+    uint32_t underruns;     // чанк дозаполнен позже, чем DMA до него дошёл
+    uint32_t frame_cycles;  // такты от led_strip_show() до конца сброса
+} led_strip_stats_t;
+
+#if LED_STRIP_ENABLED
+
+void led_strip_init(void);
+
+// Пиксель в буфере рисования; w учитывается только у SK6812
+void led_strip_pixel_set(uint16_t idx, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+
+// Отдаёт буфер рисования на вывод первых count пикселей и меняет буферы
+// местами (новый буфер рисования получает копию кадра). false - предыдущий
+// кадр ещё выводится, ничего не сделано
+bool led_strip_show(uint16_t count);
+bool led_strip_busy(void);
+
+void led_strip_stats_get(led_strip_stats_t * p_stats);
+
+#endif
+
+#endif
@@ -1,13 +1,12 @@
 #include <stdbool.h>
 #include <stdint.h>
-#include <math.h>
+#include <string.h>
 #include "nrf_gpio.h"
-#include "nrfx_pwm.h"
 #include "nrfx_gpiote.h"
 #include "app_timer.h"
 #include "nrf_drv_clock.h"
+#include "nrfx_rtc.h"
 #include "nrfx_nvmc.h"
-#include "nrf_pwm.h"
 #include "sdk_errors.h"
 #include "app_error.h"
 #include "nrf_log.h"
@@ -15,25 +14,41 @@
 #include "nrf_log_default_backends.h"
 #include "nrf_drv_power.h"
 #include "cli.h" 
+#include "color.h"
+#include "led.h"
+#include "led_pwm.h"
+#include "led_strip.h"
+#include "anim.h"
+#include "effect.h"
+#include "scene.h"
+#include "journal.h"
+#include "nvm.h"
+#include "persist.h"
+#include "perf.h"
+#include "nrf_atomic.h"
+#include "app_util_platform.h"
 
-#define LED0_PIN 6
-#define LED1_PIN 8
-#define LED2_PIN 41
-#define LED3_PIN 12
 #define BUTTON_PIN 38
-#define PWM_CHANNELS 4
-#define PWM_TOP_VALUE 1000U
-#define MAIN_INTERVAL_MS 20
 #define DEBOUNCE_MS 50
 #define DOUBLE_CLICK_MS 400
-#define HOLD_INTERVAL_MS MAIN_INTERVAL_MS
-#define HOLD_STEP_H 1
-#define HOLD_STEP_SV 1
+#define HOLD_INTERVAL_MS 20
+#define FADE_INTERVAL_MS 20
+// Полный проход параметра при удержании на базовой скорости:
+// 1 градус / 1% за 20 мс. Разгон - профилем led_hold_profile_t
+#define HOLD_SWEEP_H_MS 7200
+#define HOLD_SWEEP_SV_MS 2000
+#define HOLD_PROFILE_MAGIC 0x401DAC01
+// Часы led_time_ms: RTC0 идёт всегда, 24 бита при 1024 Гц - переполнение
+// раз в 4.5 ч, его прерывание почти не влияет на счёт пробуждений
+#define TIME_RTC_HZ 1024
 #define SLOW_BLINK_PERIOD_MS 1500
 #define FAST_BLINK_PERIOD_MS 500
+// Старая страница настроек: только читается, пока журнал пуст
 #define FLASH_SAVE_ADDR 0x7F000
+// Журнал настроек: кольцо из двух страниц
+#define SETTINGS_JOURNAL_ADDR 0x7B000
+#define SETTINGS_JOURNAL_PAGES 2
 
-void pwm_init(void);
 void button_init(void);
 void main_timer_handler(void * p_context);
 void debounce_timer_handler(void * p_context);
@@ -41,14 +56,13 @@ void double_click_timer_handler(void * p_context);
 void button_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action);
 static void update_indicator_params_for_mode(void);
 static inline int clamp_int(int v, int lo, int hi);
-static void hsv_to_rgb(float h, int s, int v, uint16_t *r, uint16_t *g, uint16_t *b);
-static void pwm_write_channels(uint16_t ch0, uint16_t ch1, uint16_t ch2, uint16_t ch3);
-void save_hsv_to_flash(void);
+static void render_frame(void);
+static void hold_update(void);
+static void hold_apply(uint32_t now_ms);
+static void settings_flush(void);
+static void time_init(void);
 bool load_hsv_from_flash(void);
 
-static nrfx_pwm_t m_pwm_instance = NRFX_PWM_INSTANCE(0);
-static nrf_pwm_values_individual_t m_seq_values;
-
 typedef enum {
     MODE_NONE = 0,
     MODE_HUE,
@@ -57,14 +71,12 @@ typedef enum {
 } input_mode_t;
 
 volatile input_mode_t m_mode = MODE_NONE;
-volatile float m_h = 0.0f;
+volatile uint16_t m_h = 0;
 volatile int m_s = 100;
 volatile int m_v = 100;
 volatile int dir_h = 1;
 volatile int dir_s = 1;
 volatile int dir_v = 1;
-volatile int m_indicator_duty = 0;
-volatile int m_indicator_dir = 1;
 volatile bool m_button_blocked = false;
 volatile bool m_first_click_detected = false;
 volatile bool m_button_held = false;
@@ -72,8 +84,78 @@ volatile bool m_button_held = false;
 APP_TIMER_DEF(main_timer);
 APP_TIMER_DEF(debounce_timer);
 APP_TIMER_DEF(double_click_timer);
-static uint32_t m_indicator_step = 1;
-static uint32_t m_indicator_period_ms = SLOW_BLINK_PERIOD_MS;
+
+// Поколение цвета: растёт при каждом изменении m_h/m_s/m_v
+static nrf_atomic_u32_t m_color_gen = 0;
+static uint32_t m_rendered_gen = UINT32_MAX;
+static color_hsv_t m_target_hsv[LED_PWM_FIXTURES];
+static uint16_t m_rgb[LED_PWM_FIXTURES * 3];   // целевые уровни 0..65535 для led_pwm_write
+// Что сейчас на выходе: совпадает с целью, пока нет перехода
+static color_hsv_t m_out_hsv[LED_PWM_FIXTURES];
+static uint16_t m_out[LED_PWM_FIXTURES * 3];
+// Плавный переход от m_fade_from* к цели за m_fade_len мс
+static uint32_t m_fade_ms = LED_FADE_DEFAULT_MS;
+static led_fade_space_t m_fade_space = LED_FADE_HSV;
+static bool m_fade_active;
+static uint32_t m_fade_t0;
+static uint32_t m_fade_len;
+static color_hsv_t m_fade_from_hsv[LED_PWM_FIXTURES];
+static uint16_t m_fade_from[LED_PWM_FIXTURES * 3];
+// Откуда берётся общий цвет; фикстуры со своим цветом источник не трогает
+typedef enum {
+    SRC_COLOR,               // m_h/m_s/m_v
+    SRC_EFFECT,
+    SRC_SCENE
+} color_src_t;
+
+static color_src_t m_src = SRC_COLOR;
+static effect_t m_effect;
+static scene_player_t m_scene;
+// Собственный цвет фикстуры; без него фикстура повторяет m_h/m_s/m_v
+static color_hsv_t m_fixture_hsv[LED_PWM_FIXTURES];
+static bool m_fixture_own[LED_PWM_FIXTURES];
+static led_render_stats_t m_render_stats;
+// Запрошенные интервалы тиков по источникам, 0 - источнику тики не нужны.
+// main_timer однократный и перезаводится на минимальный из них; без
+// запросов он стоит, статичный кадр держат PWM и RTC2 без ядра
+static uint32_t m_tick_req[LED_TICK_SRC_COUNT];
+static volatile bool m_tick_armed;
+static uint32_t m_tick_ms;
+static bool m_in_tick;
+static led_power_stats_t m_power;
+static const nrfx_rtc_t m_time_rtc = NRFX_RTC_INSTANCE(0);
+static volatile uint32_t m_time_overflows;
+// Удержание кнопки: пилообразный проход параметра ключевыми кадрами от
+// текущего значения к краю в направлении dir, затем между краями
+static anim_key_t m_hold_keys[3];
+static anim_t m_hold_anim;
+static bool m_hold_active;
+static int m_hold_dir;
+static led_hold_profile_t m_hold_profile = {
+    .delay_ms = LED_HOLD_DELAY_MS,
+    .ramp_ms  = LED_HOLD_RAMP_MS,
+    .max_x    = LED_HOLD_MAX_X,
+    .fine     = 0
+};
+
+// Запись настроек: первое слово - HSV, как и на старой странице, дальше
+// профиль удержания со своей меткой
+typedef struct {
+    uint32_t hsv;
+    uint32_t hold_magic;
+    led_hold_profile_t hold;
+} flash_settings_t;
+
+#define SETTINGS_WORDS (sizeof(flash_settings_t) / sizeof(uint32_t))
+// Запись журнала и барьер settings_saved
+#define SETTINGS_FLUSH_OPS (JOURNAL_APPEND_OPS(SETTINGS_WORDS) + 1U)
+STATIC_ASSERT(SETTINGS_FLUSH_OPS <= NVM_QUEUE_LEN);
+
+static journal_t m_settings_journal;
+// Последняя сохранённая запись: одинаковые в журнал не пишем
+static flash_settings_t m_settings_saved;
+// Такты на проверку и загрузку всего сохранённого при старте
+static uint32_t m_flash_load_cycles;
 
 int main(void) {
     ret_code_t err_code = nrf_drv_clock_init();
@@ -85,175 +167,582 @@ int main(void) {
     APP_ERROR_CHECK(err_code);
 
     app_timer_init();
+    time_init();
+    persist_init();
     
     err_code = NRF_LOG_INIT(NULL);
     APP_ERROR_CHECK(err_code);
     NRF_LOG_DEFAULT_BACKENDS_INIT();
 
+    perf_cycles_init();
+    uint32_t t0 = perf_cycles();
+    persist_register(PERSIST_SETTINGS, settings_flush, SETTINGS_FLUSH_OPS);
     if (!load_hsv_from_flash()) {
-        m_s = 100;
-        m_v = 100;
-        m_h = (77.0f / 100.0f) * 360.0f;
+        m_h = LED_DEFAULT_H;
+        m_s = LED_DEFAULT_S;
+        m_v = LED_DEFAULT_V;
     }
+    m_flash_load_cycles = perf_cycles() - t0;
+    led_pwm_init();
+    // Первый кадр рисуем сразу: m_rendered_gen заведомо не совпадает
+    render_frame();
     update_indicator_params_for_mode();
-    pwm_init();
+#if LED_STRIP_ENABLED
+    led_strip_init();
+#endif
+    app_timer_create(&main_timer, APP_TIMER_MODE_SINGLE_SHOT, main_timer_handler);
     button_init();
     
     usb_cli_init();
+    t0 = perf_cycles();
     load_colors_from_flash();
-    
-    uint16_t r, g, b;
-    hsv_to_rgb(m_h, m_s, m_v, &r, &g, &b);
-    pwm_write_channels(0, r, g, b);
+    m_flash_load_cycles += perf_cycles() - t0;
+    NRF_LOG_INFO("Flash проверен за %lu мкс", led_flash_load_us());
     
     while (1) {
         usb_cli_process();
+        persist_process();
+        nvm_process();
         
-        if (NRF_LOG_PROCESS() == false) {
+        // Пока идёт запись во flash, не спим: очередь идёт по шагу за проход
+        if (NRF_LOG_PROCESS() == false && !nvm_busy()) {
             __WFE();
+            m_power.wakeups++;
         }
     }
 }
 
+// Старший бит байта S (S не больше 100): оттенок записан углом. Без него
+// слово записано прошивкой, хранившей оттенок в градусах 0..360
+#define HSV_HUE_ANGLE_FLAG 0x80U
+
 static uint32_t pack_hsv(void) {
-    return ((uint32_t)((int)m_h) << 16) | ((uint32_t)m_s << 8) | m_v;
+    return ((uint32_t)m_h << 16) | ((uint32_t)(m_s | HSV_HUE_ANGLE_FLAG) << 8) | m_v;
 }
 
 static void unpack_hsv(uint32_t packed) {
-    m_h = (float)((packed >> 16) & 0xFFFF);
-    m_s = (packed >> 8) & 0xFF;
+    uint32_t s = (packed >> 8) & 0xFF;
+    uint32_t h = packed >> 16;
+
+    if (!(s & HSV_HUE_ANGLE_FLAG)) {
+        h = COLOR_HUE_FROM_DEG(clamp_int((int)h, 0, 360));
+    }
+    m_h = (uint16_t)h;
+    m_s = s & ~HSV_HUE_ANGLE_FLAG;
     m_v = packed & 0xFF;
 }
 
-void save_hsv_to_flash(void) {
-    uint32_t data = pack_hsv();
-    uint32_t *p_flash = (uint32_t *)FLASH_SAVE_ADDR;
-    if (*p_flash == data) return;
-    
-    NRF_LOG_INFO("Сохраняю настройки HSV: H=%d, S=%d, V=%d", (int)m_h, m_s, m_v);
-    nrfx_nvmc_page_erase(FLASH_SAVE_ADDR);
-    nrfx_nvmc_word_write(FLASH_SAVE_ADDR, data);
-    while (!nrfx_nvmc_write_done_check());
+static void settings_saved(void *p_context, bool ok) {
+    (void)p_context;
+    if (ok) {
+        NRF_LOG_INFO("Настройки записаны во flash");
+    } else {
+        NRF_LOG_ERROR("Настройки не записаны: NVMC не принял операцию");
+    }
+}
+
+// Дописывает запись в журнал, только если что-то поменялось. Стирание
+// страницы - раз на 145 записей по 28 байт, а не на каждое сохранение.
+// Сама запись идёт из главного цикла очередью NVM
+static bool settings_save(uint32_t hsv) {
+    flash_settings_t data = {
+        .hsv = hsv,
+        .hold_magic = HOLD_PROFILE_MAGIC,
+        .hold = m_hold_profile
+    };
+    if (memcmp(&m_settings_saved, &data, sizeof(data)) == 0) return false;
+
+    journal_append(&m_settings_journal, (uint32_t const *)&data);
+    nvm_barrier(settings_saved, NULL);
+    m_settings_saved = data;
+    return true;
+}
+
+// Зовёт persist, когда правки затихли
+static void settings_flush(void) {
+    if (settings_save(pack_hsv())) {
+        NRF_LOG_INFO("Сохраняю настройки HSV: H=%d, S=%d, V=%d", COLOR_HUE_TO_DEG(m_h), m_s, m_v);
+    }
+}
+
+// Старая страница настроек: CRC в ней нет. Прошивка до журнала стирала
+// страницу и писала одно слово HSV с оттенком в градусах. Проверяем
+// диапазоны и то, что остаток страницы стёрт: оборванное стирание и мусор
+// так не пройдут
+static bool legacy_settings_read(flash_settings_t *p_settings) {
+    flash_settings_t const *p = (flash_settings_t const *)FLASH_SAVE_ADDR;
+    uint32_t const *p_page = (uint32_t const *)FLASH_SAVE_ADDR;
+
+    if ((p->hsv >> 16) > 360 || ((p->hsv >> 8) & 0xFF) > 100 || (p->hsv & 0xFF) > 100) {
+        return false;
+    }
+    for (uint32_t i = 1; i < NVM_PAGE_SIZE / sizeof(uint32_t); i++) {
+        if (p_page[i] != JOURNAL_ERASED) return false;
+    }
+    memcpy(p_settings, p, sizeof(*p_settings));
+    return true;
 }
 
 bool load_hsv_from_flash(void) {
-    uint32_t *p_flash = (uint32_t *)FLASH_SAVE_ADDR;
-    uint32_t data = *p_flash;
-    if (data == 0xFFFFFFFF) return false; 
-    
-    unpack_hsv(data);
-    m_h = clamp_int((int)m_h, 0, 360);
+    journal_init(&m_settings_journal, nvm_async(), SETTINGS_JOURNAL_ADDR,
+                 SETTINGS_JOURNAL_PAGES, NVM_PAGE_SIZE, SETTINGS_WORDS);
+    if (journal_mount(&m_settings_journal)) {
+        journal_read(&m_settings_journal, (uint32_t *)&m_settings_saved);
+    } else if (legacy_settings_read(&m_settings_saved)) {
+        // Сразу переносим в журнал: дальше настройки живут под CRC. Запись
+        // в журнале отличается от старой (метка угла в S), так что уйдёт
+        persist_mark(PERSIST_SETTINGS);
+    } else {
+        return false;
+    }
+
+    if (m_settings_saved.hold_magic == HOLD_PROFILE_MAGIC) {
+        led_hold_profile_set(&m_settings_saved.hold);
+    }
+
+    unpack_hsv(m_settings_saved.hsv);
     m_s = clamp_int(m_s, 0, 100);
     m_v = clamp_int(m_v, 0, 100);
     return true;
 }
 
+void led_hold_profile_set(led_hold_profile_t const *p_profile) {
+    led_hold_profile_t p = *p_profile;
+    if (p.max_x < 1) p.max_x = 1;
+    if (p.max_x > LED_HOLD_MAX_X_LIMIT) p.max_x = LED_HOLD_MAX_X_LIMIT;
+    p.fine = p.fine ? 1 : 0;
+
+    CRITICAL_REGION_ENTER();
+    m_hold_profile = p;
+    CRITICAL_REGION_EXIT();
+}
+
+void led_hold_profile_get(led_hold_profile_t *p_profile) {
+    *p_profile = m_hold_profile;
+}
+
+void led_hold_profile_save(void) {
+    persist_mark(PERSIST_SETTINGS);
+}
+
+uint32_t led_flash_load_us(void) {
+    return m_flash_load_cycles / PERF_CYCLES_PER_US;
+}
+
+void led_settings_journal_stats_get(journal_stats_t *p_stats) {
+    *p_stats = m_settings_journal.stats;
+}
+
 static inline int clamp_int(int v, int lo, int hi) {
     if (v < lo) return lo;
     if (v > hi) return hi;
     return v;
 }
 
-void hsv_to_rgb(float h, int s, int v, uint16_t *r, uint16_t *g, uint16_t *b) {
-    float H = h;
-    float S = s / 100.0f;
-    float V = v / 100.0f;
+// Минимальный ненулевой интервал среди источников, 0 - тики не нужны
+static uint32_t tick_interval_ms(void) {
+    uint32_t ms = 0;
+    for (uint32_t k = 0; k < LED_TICK_SRC_COUNT; k++) {
+        if (m_tick_req[k] != 0 && (ms == 0 || m_tick_req[k] < ms)) {
+            ms = m_tick_req[k];
+        }
+    }
+    return ms;
+}
+
+// Заводит main_timer, если он стоит, а тики кому-то нужны. Вызывается в
+// критической секции или из обработчика тика. Новый, более частый запрос
+// вступает в силу со следующего тика
+static void tick_schedule(void) {
+    if (m_tick_armed) return;
 
-    if (S <= 0.0f) {
-        uint16_t val = (uint16_t)(V * PWM_TOP_VALUE + 0.5f);
-        *r = *g = *b = val;
-        return;
+    uint32_t ms = tick_interval_ms();
+    m_tick_ms = ms;
+    if (ms == 0) return;
+
+    m_tick_armed = true;
+    app_timer_start(main_timer, APP_TIMER_TICKS(ms), NULL);
+}
+
+void led_tick_request(led_tick_src_t src, uint32_t interval_ms) {
+    if (src >= LED_TICK_SRC_COUNT) return;
+
+    CRITICAL_REGION_ENTER();
+    m_tick_req[src] = interval_ms;
+    tick_schedule();
+    CRITICAL_REGION_EXIT();
+}
+
+void led_color_changed(void) {
+    nrf_atomic_u32_add(&m_color_gen, 1);
+    persist_mark(PERSIST_SETTINGS);
+    // Внутри тика кадр нарисует сам тик
+    if (m_in_tick) return;
+
+    // Вне тика кадр рисуется сразу: будить ради него main_timer не нужно,
+    // задержка - это пересчёт цвета и запись в PWM
+    uint32_t t0 = perf_cycles();
+    CRITICAL_REGION_ENTER();
+    render_frame();
+    m_render_stats.wakes++;
+    m_render_stats.wake_cycles = perf_cycles() - t0;
+    CRITICAL_REGION_EXIT();
+}
+
+// Переход начинается с того, что сейчас на выходе, даже посреди другого.
+// Вызывается в критической секции
+static bool fade_begin(uint32_t now_ms) {
+    if (m_fade_ms == 0) return false;
+
+    memcpy(m_fade_from_hsv, m_out_hsv, sizeof(m_fade_from_hsv));
+    memcpy(m_fade_from, m_out, sizeof(m_fade_from));
+    m_fade_t0 = now_ms;
+    m_fade_len = m_fade_ms;
+    m_fade_active = true;
+    return true;
+}
+
+void led_color_set(color_hsv_t const *p_hsv) {
+    uint32_t now = led_time_ms();
+    bool fade;
+
+    CRITICAL_REGION_ENTER();
+    fade = fade_begin(now);
+    m_h = p_hsv->h;
+    m_s = p_hsv->s;
+    m_v = p_hsv->v;
+    CRITICAL_REGION_EXIT();
+
+    if (fade) led_tick_request(LED_TICK_ANIM, FADE_INTERVAL_MS);
+    led_color_changed();
+}
+
+// Источник входит и выходит через обычный переход; дальше кадры по
+// времени, тик заказывается на срок, который вернул источник
+static void src_changed(bool fade) {
+    led_tick_request(LED_TICK_EFFECT, 0);
+    if (fade) led_tick_request(LED_TICK_ANIM, FADE_INTERVAL_MS);
+    led_color_changed();
+}
+
+static void src_stop(color_src_t src) {
+    uint32_t now = led_time_ms();
+    bool fade = false;
+    bool stop;
+
+    CRITICAL_REGION_ENTER();
+    stop = m_src == src;
+    if (stop) {
+        fade = fade_begin(now);
+        m_src = SRC_COLOR;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (stop) src_changed(fade);
+}
+
+void led_effect_start(effect_id_t id, effect_params_t const *p_params) {
+    uint32_t now = led_time_ms();
+    bool fade;
+
+    CRITICAL_REGION_ENTER();
+    fade = fade_begin(now);
+    effect_start(&m_effect, id, p_params, now);
+    m_src = SRC_EFFECT;
+    CRITICAL_REGION_EXIT();
+
+    src_changed(fade);
+}
+
+void led_effect_stop(void) {
+    src_stop(SRC_EFFECT);
+}
+
+bool led_effect_get(effect_id_t *p_id) {
+    *p_id = m_effect.id;
+    return m_src == SRC_EFFECT;
+}
+
+void led_scene_start(scene_cue_t const *p_cues, uint16_t count, bool loop) {
+    uint32_t now = led_time_ms();
+    bool fade;
+
+    CRITICAL_REGION_ENTER();
+    fade = fade_begin(now);
+    scene_start(&m_scene, p_cues, count, loop, now);
+    m_src = SRC_SCENE;
+    CRITICAL_REGION_EXIT();
+
+    src_changed(fade);
+}
+
+void led_scene_stop(void) {
+    src_stop(SRC_SCENE);
+}
+
+bool led_scene_get(uint16_t *p_idx, bool *p_done) {
+    *p_idx = m_scene.idx;
+    *p_done = m_scene.done;
+    return m_src == SRC_SCENE;
+}
+
+void led_fade_set(uint32_t ms, led_fade_space_t space) {
+    CRITICAL_REGION_ENTER();
+    m_fade_ms = ms;
+    m_fade_space = space;
+    CRITICAL_REGION_EXIT();
+}
+
+void led_fade_get(uint32_t *p_ms, led_fade_space_t *p_space) {
+    *p_ms = m_fade_ms;
+    *p_space = m_fade_space;
+}
+
+void led_fixture_set(uint8_t idx, color_hsv_t const *p_hsv) {
+    if (idx >= LED_PWM_FIXTURES) return;
+
+    CRITICAL_REGION_ENTER();
+    if (p_hsv) {
+        m_fixture_hsv[idx] = *p_hsv;
+        m_fixture_own[idx] = true;
+    } else {
+        m_fixture_own[idx] = false;
     }
+    CRITICAL_REGION_EXIT();
+    led_color_changed();
+}
 
-    if (H >= 360.0f) H = 0.0f;
-    float hf = H / 60.0f;
-    int i = (int)floorf(hf);
-    float f = hf - i;
-    float p = V * (1.0f - S);
-    float q = V * (1.0f - S * f);
-    float t = V * (1.0f - S * (1.0f - f));
-
-    float rf=0, gf=0, bf=0;
-    switch (i) {
-        case 0: rf = V; gf = t; bf = p; break;
-        case 1: rf = q; gf = V; bf = p; break;
-        case 2: rf = p; gf = V; bf = t; break;
-        case 3: rf = p; gf = q; bf = V; break;
-        case 4: rf = t; gf = p; bf = V; break;
-        case 5:
-        default: rf = V; gf = p; bf = q; break;
+static void time_rtc_handler(nrfx_rtc_int_type_t int_type) {
+    if (int_type == NRFX_RTC_INT_OVERFLOW) {
+        m_time_overflows++;
     }
+}
+
+// RTC1 у app_timer останавливается без таймеров, поэтому время считает
+// отдельный RTC0: он не стоит и в простое, переполнения считает прерывание
+static void time_init(void) {
+    nrfx_rtc_config_t config = NRFX_RTC_DEFAULT_CONFIG;
+    config.prescaler = RTC_FREQ_TO_PRESCALER(TIME_RTC_HZ);
 
-    *r = (uint16_t)(clamp_int((int)roundf(rf * PWM_TOP_VALUE), 0, PWM_TOP_VALUE));
-    *g = (uint16_t)(clamp_int((int)roundf(gf * PWM_TOP_VALUE), 0, PWM_TOP_VALUE));
-    *b = (uint16_t)(clamp_int((int)roundf(bf * PWM_TOP_VALUE), 0, PWM_TOP_VALUE));
+    ret_code_t err_code = nrfx_rtc_init(&m_time_rtc, &config, time_rtc_handler);
+    APP_ERROR_CHECK(err_code);
+    nrfx_rtc_overflow_enable(&m_time_rtc, true);
+    nrfx_rtc_enable(&m_time_rtc);
 }
 
-static void pwm_write_channels(uint16_t ch0, uint16_t ch1, uint16_t ch2, uint16_t ch3) {
-    m_seq_values.channel_0 = ch0;
-    m_seq_values.channel_1 = ch1;
-    m_seq_values.channel_2 = ch2;
-    m_seq_values.channel_3 = ch3;
+uint32_t led_time_ms(void) {
+    uint64_t ticks;
+
+    CRITICAL_REGION_ENTER();
+    uint32_t overflows = m_time_overflows;
+    uint32_t cnt = nrfx_rtc_counter_get(&m_time_rtc);
+    // Переполнение уже было, но прерывание ждёт выхода из критической секции
+    if (nrf_rtc_event_pending(m_time_rtc.p_reg, NRF_RTC_EVENT_OVERFLOW)) {
+        overflows++;
+        cnt = nrfx_rtc_counter_get(&m_time_rtc);
+    }
+    ticks = ((uint64_t)overflows << 24) | cnt;
+    CRITICAL_REGION_EXIT();
+    return (uint32_t)(ticks * 1000 / TIME_RTC_HZ);
+}
+
+void led_render_stats_get(led_render_stats_t *p_stats) {
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_render_stats;
+    CRITICAL_REGION_EXIT();
+}
+
+void led_power_stats_get(led_power_stats_t *p_stats) {
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_power;
+    p_stats->tick_ms = m_tick_armed ? m_tick_ms : 0;
+    CRITICAL_REGION_EXIT();
+    p_stats->time_ms = led_time_ms();
+}
+
+// Кадр перехода: доля пути по времени, затем интерполяция в Q16 - в HSV
+// с пересчётом в уровни или сразу в уровнях (линейный свет)
+static void fade_frame(void) {
+    uint32_t t0 = perf_cycles();
+    uint32_t elapsed = led_time_ms() - m_fade_t0;
+
+    if (elapsed >= m_fade_len) {
+        m_fade_active = false;
+        memcpy(m_out_hsv, m_target_hsv, sizeof(m_out_hsv));
+        memcpy(m_out, m_rgb, sizeof(m_out));
+        led_tick_request(LED_TICK_ANIM, 0);
+        return;
+    }
+
+    uint32_t u = (uint32_t)(((uint64_t)elapsed << 16) / m_fade_len);
+    for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+        m_out_hsv[f] = anim_lerp_hsv_wrap(&m_fade_from_hsv[f], &m_target_hsv[f], u);
+    }
+    if (m_fade_space == LED_FADE_HSV) {
+        color_hsv_to_level16_batch(m_out_hsv, LED_PWM_FIXTURES, m_out, 3);
+    } else {
+        anim_lerp_levels(m_fade_from, m_rgb, m_out, LED_PWM_FIXTURES * 3, u);
+    }
+    m_render_stats.fade_cycles += perf_cycles() - t0;
+    m_render_stats.fade_frames++;
+}
+
+// Пересчёт цвета и запись в ШИМ только если что-то изменилось или идёт переход
+static void render_frame(void) {
+    uint32_t gen = m_color_gen;
+    m_render_stats.ticks++;
+
+    // Эффект и сцена меняют цель по времени
+    bool dirty = gen != m_rendered_gen || m_src != SRC_COLOR;
+    if (!dirty && !m_fade_active) {
+        return;
+    }
+
+    if (dirty) {
+        // Все фикстуры одним проходом пакетного преобразования
+        uint32_t t0 = perf_cycles();
+        uint32_t next_ms = 0;
+        color_hsv_t fx[LED_PWM_FIXTURES];
+        if (m_src == SRC_EFFECT) {
+            next_ms = effect_render(&m_effect, led_time_ms(), fx, LED_PWM_FIXTURES);
+        } else if (m_src == SRC_SCENE) {
+            next_ms = scene_step(&m_scene, led_time_ms(), &fx[0]);
+            for (uint32_t f = 1; f < LED_PWM_FIXTURES; f++) fx[f] = fx[0];
+        }
+        for (uint32_t f = 0; f < LED_PWM_FIXTURES; f++) {
+            if (m_fixture_own[f]) {
+                m_target_hsv[f] = m_fixture_hsv[f];
+            } else if (m_src != SRC_COLOR) {
+                m_target_hsv[f] = fx[f];
+            } else {
+                m_target_hsv[f].h = m_h;
+                m_target_hsv[f].s = (uint8_t)m_s;
+                m_target_hsv[f].v = (uint8_t)m_v;
+            }
+        }
+        color_hsv_to_level16_batch(m_target_hsv, LED_PWM_FIXTURES, m_rgb, 3);
+        m_render_stats.convert_cycles += perf_cycles() - t0;
+        m_render_stats.converted++;
+        m_rendered_gen = gen;
+        if (m_src != SRC_COLOR) led_tick_request(LED_TICK_EFFECT, next_ms);
+    }
+
+    if (m_fade_active) {
+        fade_frame();
+    } else {
+        memcpy(m_out_hsv, m_target_hsv, sizeof(m_out_hsv));
+        memcpy(m_out, m_rgb, sizeof(m_out));
+    }
+
+    led_pwm_write(m_out);
+    m_render_stats.written++;
 }
 
+// Форма индикатора строится один раз на смену режима, дальше её играет PWM1
 static void update_indicator_params_for_mode(void) {
     switch (m_mode) {
         case MODE_NONE:
-            m_indicator_period_ms = 0;
-            m_indicator_duty = 0;
-            m_indicator_dir = 1;
+            led_pwm_indicator_off();
             break;
         case MODE_HUE:
-            m_indicator_period_ms = SLOW_BLINK_PERIOD_MS;
+            led_pwm_indicator_breathe(SLOW_BLINK_PERIOD_MS);
             break;
         case MODE_SAT:
-            m_indicator_period_ms = FAST_BLINK_PERIOD_MS;
+            led_pwm_indicator_breathe(FAST_BLINK_PERIOD_MS);
             break;
         case MODE_VAL:
-            m_indicator_period_ms = 1;
-            m_indicator_duty = PWM_TOP_VALUE;
+            led_pwm_indicator_const(PWM_TOP_VALUE);
             break;
     }
-    if (m_indicator_period_ms > 0) {
-        m_indicator_step = (int)ceilf((float)PWM_TOP_VALUE * ((float)MAIN_INTERVAL_MS / (m_indicator_period_ms / 2.0f)));
-        if (m_indicator_step < 1) m_indicator_step = 1;
-    } else {
-        m_indicator_step = PWM_TOP_VALUE;
-    }
     NRF_LOG_INFO("Режим настройки HSV: %d", m_mode);
 }
 
-void pwm_init(void) {
-    nrfx_pwm_config_t config = NRFX_PWM_DEFAULT_CONFIG;
-    config.output_pins[0] = LED0_PIN;   
-    config.output_pins[1] = LED1_PIN;   
-    config.output_pins[2] = LED2_PIN;   
-    config.output_pins[3] = LED3_PIN;   
-    config.base_clock = NRF_PWM_CLK_1MHz;
-    config.count_mode = NRF_PWM_MODE_UP;
-    config.top_value  = PWM_TOP_VALUE;
-    config.load_mode  = NRF_PWM_LOAD_INDIVIDUAL;
-    config.step_mode  = NRF_PWM_STEP_AUTO;
+// Ключи прохода от value (0..max) к краю в направлении dir и дальше между
+// краями; длительности пропорциональны пути при полном проходе за sweep_ms
+static void hold_keys_build(int value, int max, uint32_t sweep_ms) {
+    color_hsv_t base = { .h = m_h, .s = (uint8_t)m_s, .v = (uint8_t)m_v };
+    int edge = (m_hold_dir > 0) ? max : 0;
+    int vals[3] = { value, edge, max - edge };
+    uint32_t dist = (uint32_t)(edge > value ? edge - value : value - edge);
+
+    for (uint32_t k = 0; k < 3; k++) {
+        m_hold_keys[k].hsv = base;
+        if (m_mode == MODE_HUE) m_hold_keys[k].hsv.h = (uint16_t)vals[k];
+        else if (m_mode == MODE_SAT) m_hold_keys[k].hsv.s = (uint8_t)vals[k];
+        else m_hold_keys[k].hsv.v = (uint8_t)vals[k];
+        m_hold_keys[k].ease = ANIM_EASE_LINEAR;
+        m_hold_keys[k].ms = sweep_ms;
+    }
+    m_hold_keys[0].ms = (uint32_t)((uint64_t)dist * sweep_ms / (uint32_t)max);
+}
+
+// Время на шкале базовой скорости за t мс удержания: интеграл скорости,
+// которая после delay_ms линейно растёт от 1 до max_x раз за ramp_ms
+static uint32_t hold_warp(uint32_t t) {
+    led_hold_profile_t const *p = &m_hold_profile;
 
-    ret_code_t err_code = nrfx_pwm_init(&m_pwm_instance, &config, NULL);
-    APP_ERROR_CHECK(err_code);
+    if (p->fine) return t / LED_HOLD_FINE_DIV;
+    if (t <= p->delay_ms || p->max_x <= 1) return t;
 
-    m_seq_values.channel_0 = 0;
-    m_seq_values.channel_1 = 0;
-    m_seq_values.channel_2 = 0;
-    m_seq_values.channel_3 = 0;
+    uint32_t r = t - p->delay_ms;
+    uint32_t extra = p->max_x - 1;
+    uint64_t tau = p->delay_ms;
+    if (r < p->ramp_ms) {
+        tau += r + (uint64_t)extra * r * r / (2 * p->ramp_ms);
+    } else {
+        tau += p->ramp_ms + (uint64_t)extra * p->ramp_ms / 2 + (uint64_t)(r - p->ramp_ms) * p->max_x;
+    }
+    return (tau > UINT32_MAX) ? UINT32_MAX : (uint32_t)tau;
+}
 
-    nrf_pwm_sequence_t seq = {
-        .values.p_individual = &m_seq_values,
-        .length = PWM_CHANNELS,
-        .repeats = 0,
-        .end_delay = 0
-    };
+// Цвет удержания на момент now_ms. Пропущенные тики не замедляют проход:
+// значение берётся из прошедшего времени, а не из числа тиков; разгон -
+// это перевод реального времени в время ключевых кадров
+static void hold_apply(uint32_t now_ms) {
+    anim_sample_t smp;
+    uint32_t t0 = m_hold_anim.t0_ms;
+    anim_sample(&m_hold_anim, t0 + hold_warp(now_ms - t0), &smp);
+
+    // Переход 1 (край -> другой край) идёт против исходного направления
+    int dir = (smp.seg == 1) ? -m_hold_dir : m_hold_dir;
+    if (m_mode == MODE_HUE) {
+        m_h = smp.hsv.h;
+        dir_h = dir;
+    } else if (m_mode == MODE_SAT) {
+        m_s = smp.hsv.s;
+        dir_s = dir;
+    } else if (m_mode == MODE_VAL) {
+        m_v = smp.hsv.v;
+        dir_v = dir;
+    }
+    led_color_changed();
+}
 
-    nrfx_pwm_simple_playback(&m_pwm_instance, &seq, 1, NRFX_PWM_FLAG_LOOP);
+// Запуск и остановка прохода по состоянию кнопки и режиму. Удержание в
+// режиме настройки - единственная работа, которой нужен частый тик
+static void hold_update(void) {
+    bool want = m_button_held && m_mode != MODE_NONE;
+    uint32_t now = led_time_ms();
 
-    app_timer_create(&main_timer, APP_TIMER_MODE_REPEATED, main_timer_handler);
-    app_timer_start(main_timer, APP_TIMER_TICKS(MAIN_INTERVAL_MS), NULL);
+    if (want && !m_hold_active) {
+        if (m_mode == MODE_HUE) {
+            m_hold_dir = dir_h;
+            hold_keys_build(m_h, UINT16_MAX, HOLD_SWEEP_H_MS);
+        } else if (m_mode == MODE_SAT) {
+            m_hold_dir = dir_s;
+            hold_keys_build(m_s, 100, HOLD_SWEEP_SV_MS);
+        } else {
+            m_hold_dir = dir_v;
+            hold_keys_build(m_v, 100, HOLD_SWEEP_SV_MS);
+        }
+        anim_start(&m_hold_anim, m_hold_keys, 3, 1, now);
+        m_hold_active = true;
+    } else if (!want && m_hold_active) {
+        // Доводим значение до момента отпускания
+        hold_apply(now);
+        m_hold_active = false;
+    }
+    led_tick_request(LED_TICK_HOLD, m_hold_active ? HOLD_INTERVAL_MS : 0);
 }
 
 void button_init(void) {
@@ -291,10 +780,11 @@ void debounce_timer_handler(void *p_context) {
             else if (m_mode == MODE_SAT) m_mode = MODE_VAL;
             else m_mode = MODE_NONE;
             if (m_mode == MODE_NONE && old_mode != MODE_NONE) {
-                save_hsv_to_flash();
+                persist_mark(PERSIST_SETTINGS);
             }
             dir_h = 1; dir_s = 1; dir_v = 1;
             update_indicator_params_for_mode();
+            led_color_changed();
         } else {
             m_first_click_detected = true;
             app_timer_start(double_click_timer, APP_TIMER_TICKS(DOUBLE_CLICK_MS), NULL);
@@ -304,12 +794,15 @@ void debounce_timer_handler(void *p_context) {
         m_button_held = false;
     }
 
+    hold_update();
     m_button_blocked = false;
+    m_power.rtc_irqs++;
 }
 
 void double_click_timer_handler(void *p_context) {
     (void)p_context;
     m_first_click_detected = false;
+    m_power.rtc_irqs++;
 }
 
 void button_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action) {
@@ -321,65 +814,23 @@ void button_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action) {
 
 void main_timer_handler(void *p_context) {
     (void)p_context;
-    if (m_button_held && m_mode != MODE_NONE) {
-        if (m_mode == MODE_HUE) {
-            m_h += dir_h * HOLD_STEP_H;
-            if (m_h >= 360.0f) {
-                m_h = 360.0f;
-                dir_h = -1;
-            } else if (m_h <= 0.0f) {
-                m_h = 0.0f;
-                dir_h = 1;
-            }
-        }
-        else if (m_mode == MODE_SAT) {
-            m_s += dir_s * HOLD_STEP_SV;
-            if (m_s >= 100) {
-                m_s = 100;
-                dir_s = -1;
-            } else if (m_s <= 0) {
-                m_s = 0;
-                dir_s = 1;
-            }
-        }
-        else if (m_mode == MODE_VAL) {
-            m_v += dir_v * HOLD_STEP_SV;
-            if (m_v >= 100) {
-                m_v = 100;
-                dir_v = -1;
-            } else if (m_v <= 0) {
-                m_v = 0;
-                dir_v = 1;
-            }
-        }
-        NRF_LOG_INFO("HSV: H=%d, S=%d, V=%d", (int)m_h, m_s, m_v);
+    m_tick_armed = false;
+    m_in_tick = true;
+    m_power.ticks++;
+    m_power.rtc_irqs++;
+
+    if (m_hold_active) {
+        hold_apply(led_time_ms());
+        NRF_LOG_INFO("HSV: H=%d, S=%d, V=%d", COLOR_HUE_TO_DEG(m_h), m_s, m_v);
     }
 
-    uint16_t ind = 0;
-    if (m_mode == MODE_NONE) {
-        ind = 0;
-        m_indicator_duty = 0;
-    } else if (m_mode == MODE_VAL) {
-        ind = PWM_TOP_VALUE;
-        m_indicator_duty = PWM_TOP_VALUE;
-    } else {
-        if (m_indicator_period_ms > 0) {
-            m_indicator_duty += (int)m_indicator_step * m_indicator_dir;
-            if (m_indicator_duty >= (int)PWM_TOP_VALUE) {
-                m_indicator_duty = PWM_TOP_VALUE;
-                m_indicator_dir = -1;
-            } else if (m_indicator_duty <= 0) {
-                m_indicator_duty = 0;
-                m_indicator_dir = 1;
-            }
-            ind = (uint16_t)clamp_int(m_indicator_duty, 0, PWM_TOP_VALUE);
-        } else {
-            ind = 0;
-        }
-    }
+    render_frame();
+    m_in_tick = false;
 
-    uint16_t r, g, b;
-    hsv_to_rgb(m_h, m_s, m_v, &r, &g, &b);
-
-    pwm_write_channels(ind, r, g, b);
-}
\ No newline at end of file
+    // Обработчики app_timer не вытесняют друг друга, запросы из прерываний
+    // выше приоритетом (CLI по USB) закрываем критической секцией
+    CRITICAL_REGION_ENTER();
+    tick_schedule();
+    if (!m_tick_armed) m_render_stats.sleeps++;
+    CRITICAL_REGION_EXIT();
+}
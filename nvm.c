@@ -0,0 +1,193 @@
+#include "nvm.h"
+#include "nrfx_nvmc.h"
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "perf.h"
+
+// tWRITE по документации - до 41 мкс на слово
+#define NVM_WORD_WRITE_US 41
+#define NVM_WRITE_BURST ((NVM_STALL_BUDGET_MS * 1000) / NVM_WORD_WRITE_US)
+
+typedef enum {
+    NVM_OP_WRITE,
+    NVM_OP_ERASE,
+    NVM_OP_BARRIER
+} nvm_op_type_t;
+
+typedef struct {
+    nvm_op_type_t type;
+    uint32_t addr;
+    uint32_t value;
+    nvm_done_handler_t handler;
+    void * p_context;
+} nvm_op_t;
+
+// Кольцо операций: ставят в очередь и прерывания, и главный цикл,
+// выполняет только главный цикл
+static nvm_op_t m_queue[NVM_QUEUE_LEN];
+static uint16_t m_head;
+static volatile uint16_t m_count;
+static bool m_erasing;
+static bool m_in_process;
+static bool m_failed;        // с прошлого барьера была ошибка
+static nvm_stats_t m_stats;
+
+static uint32_t nvmc_read(uint32_t addr) {
+    return *(uint32_t const volatile *)(uintptr_t)addr;
+}
+
+static void nvmc_write(uint32_t addr, uint32_t value) {
+    nrfx_nvmc_word_write(addr, value);
+    while (!nrfx_nvmc_write_done_check());
+}
+
+static void nvmc_erase(uint32_t page_addr) {
+    nrfx_nvmc_page_erase(page_addr);
+}
+
+static journal_nvm_t const m_nvmc = {
+    .read  = nvmc_read,
+    .write = nvmc_write,
+    .erase = nvmc_erase
+};
+
+journal_nvm_t const *nvm_nvmc(void) {
+    return &m_nvmc;
+}
+
+static void enqueue(nvm_op_t const *p_op) {
+    bool full;
+
+    CRITICAL_REGION_ENTER();
+    full = m_count == NVM_QUEUE_LEN;
+    if (!full) {
+        m_queue[(m_head + m_count) % NVM_QUEUE_LEN] = *p_op;
+        m_count++;
+    }
+    CRITICAL_REGION_EXIT();
+    if (!full) return;
+
+    // Очередь полна: доигрываем её на месте, блокируя. Прерванный шаг
+    // очереди так не доиграть, а терять запись нельзя. Сюда не попасть,
+    // пока пишущие проверяют nvm_room
+    m_stats.overflows++;
+    if (m_in_process) {
+        APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
+    }
+    while (m_count == NVM_QUEUE_LEN) {
+        nvm_process();
+    }
+    enqueue(p_op);
+}
+
+static void async_write(uint32_t addr, uint32_t value) {
+    nvm_op_t op = { .type = NVM_OP_WRITE, .addr = addr, .value = value };
+    enqueue(&op);
+}
+
+static void async_erase(uint32_t page_addr) {
+    nvm_op_t op = { .type = NVM_OP_ERASE, .addr = page_addr };
+    enqueue(&op);
+}
+
+static journal_nvm_t const m_async = {
+    .read  = nvmc_read,
+    .write = async_write,
+    .erase = async_erase
+};
+
+journal_nvm_t const *nvm_async(void) {
+    return &m_async;
+}
+
+void nvm_barrier(nvm_done_handler_t handler, void *p_context) {
+    nvm_op_t op = { .type = NVM_OP_BARRIER, .handler = handler, .p_context = p_context };
+    enqueue(&op);
+}
+
+bool nvm_room(uint32_t ops) {
+    return m_count + ops <= NVM_QUEUE_LEN;
+}
+
+bool nvm_busy(void) {
+    return m_count != 0;
+}
+
+static void pop(void) {
+    CRITICAL_REGION_ENTER();
+    m_head = (m_head + 1) % NVM_QUEUE_LEN;
+    m_count--;
+    CRITICAL_REGION_EXIT();
+}
+
+void nvm_process(void) {
+    if (m_count == 0 || m_in_process) return;
+
+    m_in_process = true;
+    uint32_t t0 = perf_cycles();
+    nvm_op_t *p_op = &m_queue[m_head];
+    nvm_done_handler_t handler = NULL;
+    void *p_context = NULL;
+    bool ok = true;
+
+    switch (p_op->type) {
+        case NVM_OP_ERASE:
+            // Один кусок стирания за шаг: между кусками идут прерывания
+            if (!m_erasing) {
+                // Стирание не началось (адрес или длительность не те):
+                // операция снимается, ошибку получит ближайший барьер
+                if (nrfx_nvmc_page_partial_erase_init(p_op->addr, NVM_STALL_BUDGET_MS) != NRFX_SUCCESS) {
+                    m_stats.failed++;
+                    m_failed = true;
+                    pop();
+                    break;
+                }
+                m_erasing = true;
+            }
+            m_stats.erase_slices++;
+            if (nrfx_nvmc_page_partial_erase_continue()) {
+                m_erasing = false;
+                m_stats.erases++;
+                pop();
+            }
+            break;
+
+        case NVM_OP_WRITE:
+            // Подряд идущие записи пачкой, пока укладываемся в бюджет
+            for (uint32_t n = 0; n < NVM_WRITE_BURST && m_count != 0; n++) {
+                p_op = &m_queue[m_head];
+                if (p_op->type != NVM_OP_WRITE) break;
+                nvmc_write(p_op->addr, p_op->value);
+                m_stats.words++;
+                pop();
+            }
+            break;
+
+        case NVM_OP_BARRIER:
+            handler = p_op->handler;
+            p_context = p_op->p_context;
+            ok = !m_failed;
+            m_failed = false;
+            pop();
+            break;
+    }
+
+    uint32_t us = (perf_cycles() - t0) / PERF_CYCLES_PER_US;
+    if (us > m_stats.stall_max_us) m_stats.stall_max_us = us;
+    m_in_process = false;
+
+    // Обработчик может сам ставить записи в очередь
+    if (handler) handler(p_context, ok);
+}
+
+void nvm_drain(void) {
+    while (m_count != 0 && !m_in_process) {
+        nvm_process();
+    }
+}
+
+void nvm_stats_get(nvm_stats_t *p_stats) {
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_stats;
+    CRITICAL_REGION_EXIT();
+}
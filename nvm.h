@@ -0,0 +1,59 @@
+#ifndef NVM_H
+#define NVM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "journal.h"
+
+#define NVM_PAGE_SIZE 4096U
+
+// Наибольший простой ядра на одну операцию очереди: стирание идёт
+// кусками ERASEPAGEPARTIAL по столько мс, запись - пачками слов в тот же срок
+#ifndef NVM_STALL_BUDGET_MS
+#define NVM_STALL_BUDGET_MS 2
+#endif
+
+// Операций в очереди. Каждая часть persist ставит свою запись, только
+// если для её худшего случая есть место (nvm_room), и проверяет при сборке,
+// что худший случай влезает в пустую очередь: журнал настроек со сменой
+// страницы - 13, сброс палитры с уплотнением - 119, копия сцены - 106
+#define NVM_QUEUE_LEN 128
+
+// ok == false - с прошлого барьера какая-то операция не выполнилась
+typedef void (*nvm_done_handler_t)(void * p_context, bool ok);
+
+typedef struct {
+    uint32_t erases;
+    uint32_t erase_slices;
+    uint32_t words;
+    uint32_t overflows;      // очередь была полна и доигрывалась на месте
+    uint32_t failed;         // операции, которые NVMC не принял
+    uint32_t stall_max_us;   // самый долгий шаг nvm_process
+} nvm_stats_t;
+
+// Встроенная flash через NVMC для журналов: запись слова ждёт готовности,
+// стирание страницы блокирует на время стирания
+journal_nvm_t const * nvm_nvmc(void);
+
+// То же через очередь: запись и стирание только ставятся в очередь и
+// выполняются nvm_process() из главного цикла. Чтение - сразу из flash,
+// поэтому монтировать журнал надо до постановки записей
+journal_nvm_t const * nvm_async(void);
+
+// handler вызовется из главного цикла, когда выполнится всё, что было
+// поставлено в очередь до него
+void nvm_barrier(nvm_done_handler_t handler, void * p_context);
+
+// В очереди есть место ещё на ops операций
+bool nvm_room(uint32_t ops);
+
+// Один шаг очереди не дольше NVM_STALL_BUDGET_MS. Вызывать из главного цикла
+void nvm_process(void);
+// Доиграть всю очередь на месте, блокируя: при пропадании питания.
+// Если прервали сам шаг очереди, ничего не делает
+void nvm_drain(void);
+// В очереди есть работа: главному циклу рано засыпать
+bool nvm_busy(void);
+void nvm_stats_get(nvm_stats_t * p_stats);
+
+#endif
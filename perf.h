@@ -0,0 +1,21 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+#include "nrf.h"
+
+// nRF52840 всегда тактируется 64 МГц
+#define PERF_CYCLES_PER_US 64U
+
+// Счётчик тактов ядра (DWT CYCCNT) для замеров
+static inline void perf_cycles_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t perf_cycles(void) {
+    return DWT->CYCCNT;
+}
+
+#endif
@@ -0,0 +1,142 @@
+#include "persist.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include "app_timer.h"
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "nrf_drv_power.h"
+#include "nvm.h"
+
+#define PERSIST_IDLE_TICKS APP_TIMER_TICKS(PERSIST_IDLE_MS)
+
+APP_TIMER_DEF(m_idle_timer);
+
+static persist_flush_t m_flush[PERSIST_COUNT];
+static uint32_t m_ops[PERSIST_COUNT];
+static volatile uint32_t m_dirty;
+static volatile uint32_t m_last_mark;    // отсчёт RTC последней правки
+static volatile bool m_idle_armed;
+static volatile bool m_idle_due;
+static volatile bool m_flushing;
+static volatile bool m_retry;            // часть ждёт места в очереди
+static persist_stats_t m_stats;
+
+static void flush_dirty(void) {
+    uint32_t dirty;
+
+    // Сброс из главного цикла прервал POFWARN: его часть уже в очереди
+    if (m_flushing) return;
+    m_flushing = true;
+
+    CRITICAL_REGION_ENTER();
+    dirty = m_dirty;
+    m_dirty = 0;
+    CRITICAL_REGION_EXIT();
+
+    m_retry = false;
+    for (uint32_t i = 0; i < PERSIST_COUNT; i++) {
+        if (!(dirty & (1U << i)) || !m_flush[i]) continue;
+
+        // Места нет: часть остаётся грязной, очередь тем временем идёт
+        if (!nvm_room(m_ops[i])) {
+            CRITICAL_REGION_ENTER();
+            m_dirty |= 1U << i;
+            CRITICAL_REGION_EXIT();
+            m_retry = true;
+            m_stats.deferred++;
+            continue;
+        }
+        m_flush[i]();
+        m_stats.flushes++;
+    }
+    m_flushing = false;
+}
+
+// Таймер не перезапускается на каждой правке: по срабатыванию смотрим,
+// сколько прошло с последней, и при надобности доспим остаток
+static void idle_timer_handler(void *p_context) {
+    (void)p_context;
+    uint32_t idle = app_timer_cnt_diff_compute(app_timer_cnt_get(), m_last_mark);
+
+    if (idle < PERSIST_IDLE_TICKS) {
+        uint32_t left = PERSIST_IDLE_TICKS - idle;
+        if (left < APP_TIMER_MIN_TIMEOUT_TICKS) left = APP_TIMER_MIN_TIMEOUT_TICKS;
+        app_timer_start(m_idle_timer, left, NULL);
+        return;
+    }
+    m_idle_armed = false;
+    // Пишет главный цикл: он проснётся по этому же прерыванию
+    m_idle_due = true;
+}
+
+// Напряжение падает: освобождаем очередь, ставим всё грязное и доигрываем
+// его на месте
+static void pofwarn_handler(void) {
+    m_stats.pof++;
+    nvm_drain();
+    flush_dirty();
+    nvm_drain();
+    if (m_retry) {
+        flush_dirty();
+        nvm_drain();
+    }
+}
+
+void persist_init(void) {
+    ret_code_t err_code = app_timer_create(&m_idle_timer, APP_TIMER_MODE_SINGLE_SHOT, idle_timer_handler);
+    APP_ERROR_CHECK(err_code);
+
+    // Порог VDDH срабатывает раньше, пока VDD за стабилизатором ещё держится
+    nrf_drv_power_pofwarn_config_t const pof_config = {
+        .handler = pofwarn_handler,
+        .thr     = NRF_POWER_POFTHR_V28,
+        .thrvddh = NRF_POWER_POFTHRVDDH_V42
+    };
+    err_code = nrf_drv_power_pof_init(&pof_config);
+    APP_ERROR_CHECK(err_code);
+}
+
+void persist_register(persist_item_t item, persist_flush_t flush, uint32_t ops) {
+    if (ops > NVM_QUEUE_LEN) {
+        APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
+    }
+    m_flush[item] = flush;
+    m_ops[item] = ops;
+}
+
+void persist_mark(persist_item_t item) {
+    bool start;
+
+    CRITICAL_REGION_ENTER();
+    m_dirty |= 1U << item;
+    m_last_mark = app_timer_cnt_get();
+    m_stats.marks++;
+    start = !m_idle_armed;
+    m_idle_armed = true;
+    CRITICAL_REGION_EXIT();
+
+    if (start) app_timer_start(m_idle_timer, PERSIST_IDLE_TICKS, NULL);
+}
+
+void persist_flush(void) {
+    m_stats.requested++;
+    flush_dirty();
+}
+
+void persist_process(void) {
+    // Отложенные части - как только очередь продвинулась
+    if (m_retry) {
+        flush_dirty();
+    }
+    if (!m_idle_due) return;
+
+    m_idle_due = false;
+    m_stats.idle++;
+    flush_dirty();
+}
+
+void persist_stats_get(persist_stats_t *p_stats) {
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_stats;
+    CRITICAL_REGION_EXIT();
+}
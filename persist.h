@@ -0,0 +1,48 @@
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stdint.h>
+
+// Отложенная запись во flash. Правки цвета, настроек, палитры и сцены только
+// помечают свою часть грязной, сама запись идёт, когда правки затихли на
+// PERSIST_IDLE_MS, по команде save или по предупреждению о пропадании
+// питания (POFWARN)
+
+#ifndef PERSIST_IDLE_MS
+#define PERSIST_IDLE_MS 5000
+#endif
+
+typedef enum {
+    PERSIST_SETTINGS,        // текущий цвет и профиль удержания
+    PERSIST_PALETTE,
+    PERSIST_SCENE,
+    PERSIST_COUNT
+} persist_item_t;
+
+// Ставит запись части в очередь NVM
+typedef void (*persist_flush_t)(void);
+
+typedef struct {
+    uint32_t marks;          // вызовов persist_mark
+    uint32_t flushes;        // записанных частей
+    uint32_t idle;           // сбросов по простою
+    uint32_t requested;      // ... по persist_flush
+    uint32_t pof;            // ... по POFWARN
+    uint32_t deferred;       // сбросов, отложенных до места в очереди NVM
+} persist_stats_t;
+
+void persist_init(void);
+// ops - операций NVM на flush в худшем случае, не больше NVM_QUEUE_LEN.
+// Часть сбрасывается, только когда под них есть место в очереди, иначе
+// остаётся грязной до следующего прохода главного цикла
+void persist_register(persist_item_t item, persist_flush_t flush, uint32_t ops);
+
+// Часть изменилась. Можно звать из прерываний, хоть на каждом кадре
+void persist_mark(persist_item_t item);
+// Записать всё грязное сейчас
+void persist_flush(void);
+// Из главного цикла: сброс по простою
+void persist_process(void);
+void persist_stats_get(persist_stats_t * p_stats);
+
+#endif
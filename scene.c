@@ -0,0 +1,69 @@
+#include "scene.h"
+#include "anim.h"
+
+void scene_start(scene_player_t *p_player, scene_cue_t const *p_cues, uint16_t count,
+                 bool loop, uint32_t now_ms) {
+    p_player->p_cues = p_cues;
+    p_player->count = count;
+    p_player->idx = 0;
+    p_player->loop = loop;
+    p_player->fading = false;
+    p_player->done = (count == 0);
+    p_player->t0_ms = now_ms;
+}
+
+uint32_t scene_step(scene_player_t *p_player, uint32_t now_ms, color_hsv_t *p_out) {
+    if (p_player->count == 0) {
+        *p_out = (color_hsv_t){ 0 };
+        return 0;
+    }
+
+    scene_cue_t const *cue = &p_player->p_cues[p_player->idx];
+    uint32_t elapsed = now_ms - p_player->t0_ms;
+    bool last = p_player->idx + 1 >= p_player->count;
+
+    // Не больше одной смены фазы за вызов; t0 сдвигается на длину фазы,
+    // а не на now, так что опоздавший тик не растягивает сцену
+    if (!p_player->done) {
+        if (!p_player->fading) {
+            if (elapsed >= cue->hold_ms) {
+                if (last && !p_player->loop) {
+                    p_player->done = true;
+                } else {
+                    p_player->fading = true;
+                    p_player->t0_ms += cue->hold_ms;
+                    elapsed -= cue->hold_ms;
+                }
+            }
+        } else if (elapsed >= cue->fade_ms) {
+            p_player->idx = last ? 0 : p_player->idx + 1;
+            p_player->fading = false;
+            p_player->t0_ms += cue->fade_ms;
+            elapsed -= cue->fade_ms;
+            cue = &p_player->p_cues[p_player->idx];
+        }
+    }
+
+    if (p_player->done) {
+        *p_out = cue->hsv;
+        return 0;
+    }
+
+    if (!p_player->fading) {
+        *p_out = cue->hsv;
+        // Пока цвет держится, кадры не нужны: будимся к концу фазы
+        if (elapsed >= cue->hold_ms) return 1;
+        uint32_t wait = cue->hold_ms - elapsed;
+        return (wait < SCENE_MAX_WAIT_MS) ? wait : SCENE_MAX_WAIT_MS;
+    }
+
+    uint16_t next_idx = (p_player->idx + 1 < p_player->count) ? p_player->idx + 1 : 0;
+    scene_cue_t const *next = &p_player->p_cues[next_idx];
+    if (elapsed >= cue->fade_ms) {
+        *p_out = next->hsv;
+        return 1;
+    }
+    uint32_t u = (uint32_t)(((uint64_t)elapsed << 16) / cue->fade_ms);
+    *p_out = anim_lerp_hsv_wrap(&cue->hsv, &next->hsv, u);
+    return SCENE_FRAME_MS;
+}
@@ -0,0 +1,41 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "color.h"
+
+// Проигрыватель сцены: цвета по очереди, каждый держится hold_ms и за
+// fade_ms переходит в следующий. Без выделения памяти, за вызов - не
+// больше одной смены фазы, поэтому цена тика не зависит от длины сцены.
+// Модуль не зависит от SDK
+
+#define SCENE_MAX_STEPS 16
+#define SCENE_FRAME_MS 20
+// Дольше app_timer заводить не будем: после паузы просто перепроверим
+#define SCENE_MAX_WAIT_MS 60000
+
+typedef struct {
+    color_hsv_t hsv;
+    uint32_t    hold_ms;
+    uint32_t    fade_ms;     // переход к следующему цвету
+} scene_cue_t;
+
+typedef struct {
+    scene_cue_t const * p_cues;
+    uint16_t count;
+    uint16_t idx;
+    bool     loop;
+    bool     fading;
+    bool     done;           // без повтора: последний цвет достигнут
+    uint32_t t0_ms;          // начало текущей фазы
+} scene_player_t;
+
+void scene_start(scene_player_t * p_player, scene_cue_t const * p_cues, uint16_t count,
+                 bool loop, uint32_t now_ms);
+
+// Цвет на момент now_ms. Возвращает, через сколько мс нужен следующий
+// кадр, 0 - сцена закончилась и кадры больше не нужны
+uint32_t scene_step(scene_player_t * p_player, uint32_t now_ms, color_hsv_t * p_out);
+
+#endif
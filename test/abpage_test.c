@@ -0,0 +1,105 @@
+// Копии A/B сцены на имитации NVMC: обрыв питания в случайной операции
+// записи, в том числе посреди стирания, обязан оставить либо прежнюю
+// копию, либо новую. Старая страница без заголовка на месте A должна
+// пережить оборванную первую запись
+#include <stdio.h>
+#include <string.h>
+#include "abpage.h"
+#include "nvm_sim.h"
+
+#define ADDR_A 0x7D000U
+#define ADDR_B 0x78000U
+#define VERSION 1
+#define WORDS 99             // flash_scene_t
+#define CUT_ROUNDS 20000
+
+static abpage_t m_ab;
+// Меняются между setjmp и longjmp: только статические
+static uint32_t m_committed;
+static uint32_t m_pending;
+static uint32_t m_next = 1;
+
+static void snapshot(uint32_t value, uint32_t *p_words) {
+    for (uint32_t i = 0; i < WORDS; i++) p_words[i] = value ^ (i * 0x01000193U);
+}
+
+// Значение загруженной копии, 0 - копии нет, ~0 - чужие данные
+static uint32_t loaded_value(void) {
+    uint32_t words[WORDS], expect[WORDS];
+
+    abpage_init(&m_ab, &nvm_sim, ADDR_A, ADDR_B, VERSION, WORDS);
+    if (!abpage_load(&m_ab, words)) return 0;
+    snapshot(m_committed, expect);
+    if (m_committed && memcmp(words, expect, sizeof(words)) == 0) return m_committed;
+    snapshot(m_pending, expect);
+    if (m_pending && memcmp(words, expect, sizeof(words)) == 0) return m_pending;
+    return ~0U;
+}
+
+static int power_cuts(void) {
+    static uint32_t bad;
+    uint32_t words[WORDS];
+
+    nvm_sim_reset(2024);
+    for (uint32_t round = 0; round < CUT_ROUNDS; round++) {
+        uint32_t value = loaded_value();
+        if (value == ~0U || (value == 0 && m_committed != 0)) {
+            if (bad++ < 5) {
+                printf("  обрыв %lu: загружено %s, ждали %lu или %lu\n", (unsigned long)round,
+                       value ? "чужое" : "пусто", (unsigned long)m_committed, (unsigned long)m_pending);
+            }
+            nvm_sim_reset(round + 1);
+            m_committed = m_pending = 0;
+            continue;
+        }
+        m_committed = m_pending = value;
+
+        nvm_sim_cut_after(1 + nvm_sim_rand() % (2 * ABPAGE_SAVE_OPS(WORDS)));
+        if (setjmp(nvm_sim_cut_env) == 0) {
+            m_pending = m_next++;
+            snapshot(m_pending, words);
+            abpage_save(&m_ab, words);
+            m_committed = m_pending;
+            nvm_sim_cut_after(0);
+        }
+    }
+    printf("%d циклов, обрывов %lu (посреди стирания %lu): ошибок %lu, перезаписей нестёртых слов %lu\n",
+           CUT_ROUNDS, (unsigned long)nvm_sim_stats.cuts, (unsigned long)nvm_sim_stats.erase_cuts,
+           (unsigned long)bad, (unsigned long)nvm_sim_stats.overwrites);
+    return bad != 0;
+}
+
+// Старая страница на месте A: первая запись идёт в B и не трогает её
+static int legacy_kept(void) {
+    static uint32_t bad, cut;
+    uint32_t words[WORDS];
+
+    for (cut = 1; cut <= ABPAGE_SAVE_OPS(WORDS); cut++) {
+        nvm_sim_reset(cut);
+        for (uint32_t i = 0; i < WORDS; i++) nvm_sim.write(ADDR_A + i * sizeof(uint32_t), 0x5CE4E001U + i);
+
+        abpage_init(&m_ab, &nvm_sim, ADDR_A, ADDR_B, VERSION, WORDS);
+        abpage_load(&m_ab, words);
+        nvm_sim_cut_after(cut);
+        if (setjmp(nvm_sim_cut_env) == 0) {
+            snapshot(1, words);
+            abpage_save(&m_ab, words);
+            nvm_sim_cut_after(0);
+        }
+        for (uint32_t i = 0; i < WORDS; i++) {
+            if (nvm_sim.read(ADDR_A + i * sizeof(uint32_t)) != 0x5CE4E001U + i) {
+                bad++;
+                break;
+            }
+        }
+    }
+    printf("старая страница на месте A после оборванной первой записи: испорчена %lu раз из %lu\n",
+           (unsigned long)bad, (unsigned long)ABPAGE_SAVE_OPS(WORDS));
+    return bad != 0;
+}
+
+int main(void) {
+    int bad = power_cuts();
+    bad |= legacy_kept();
+    return bad;
+}
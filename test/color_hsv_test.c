@@ -0,0 +1,74 @@
+// HSV -> RGB: целочисленное ядро против float-эталона на ПК. Все 65536
+// углов оттенка при S, V с шагом 5, плюс все S, V на углах с шагом 1
+// градус; допуск - ±1 отсчёт при top = PWM_TOP_VALUE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "color.h"
+
+#define TOP 1000U
+#define TOLERANCE 1
+
+static int m_max_diff;
+static unsigned long m_count;
+static unsigned long m_over;
+
+static void check(uint16_t hue, int s, int v) {
+    uint16_t r, g, b, rr, gr, br;
+    color_hsv_to_rgb(hue, (uint8_t)s, (uint8_t)v, TOP, &r, &g, &b);
+    color_hsv_to_rgb_ref((float)hue * 360.0f / COLOR_HUE_TURN, s, v, TOP, &rr, &gr, &br);
+
+    int d = abs((int)r - rr);
+    if (abs((int)g - gr) > d) d = abs((int)g - gr);
+    if (abs((int)b - br) > d) d = abs((int)b - br);
+    if (d > m_max_diff) m_max_diff = d;
+    if (d > TOLERANCE && m_over++ < 5) {
+        printf("  h=%u s=%d v=%d: %u %u %u, эталон %u %u %u\n", hue, s, v, r, g, b, rr, gr, br);
+    }
+    m_count++;
+}
+
+static double seconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+int main(void) {
+    for (uint32_t h = 0; h < COLOR_HUE_TURN; h++) {
+        for (int s = 0; s <= 100; s += 5) {
+            for (int v = 0; v <= 100; v += 5) {
+                check((uint16_t)h, s, v);
+            }
+        }
+    }
+    for (uint32_t deg = 0; deg < 360; deg++) {
+        for (int s = 0; s <= 100; s++) {
+            for (int v = 0; v <= 100; v++) {
+                check(COLOR_HUE_FROM_DEG(deg), s, v);
+            }
+        }
+    }
+
+    // Скорость: одни и те же входы через оба пути
+    enum { N = 4000000 };
+    volatile uint16_t sink = 0;
+    uint16_t r, g, b;
+    double t0 = seconds();
+    for (uint32_t i = 0; i < N; i++) {
+        color_hsv_to_rgb((uint16_t)(i * 40503U), (uint8_t)(i % 101), (uint8_t)(i % 97), TOP, &r, &g, &b);
+        sink += r + g + b;
+    }
+    double t1 = seconds();
+    for (uint32_t i = 0; i < N; i++) {
+        color_hsv_to_rgb_ref((float)(uint16_t)(i * 40503U) * 360.0f / COLOR_HUE_TURN,
+                             (int)(i % 101), (int)(i % 97), TOP, &r, &g, &b);
+        sink += r + g + b;
+    }
+    double t2 = seconds();
+    (void)sink;
+
+    printf("COLOR_HUE_LUT_BITS=%d: %lu входов, наибольшая ошибка %d, сверх допуска %lu\n",
+           COLOR_HUE_LUT_BITS, m_count, m_max_diff, m_over);
+    printf("  int %.1f нс, float %.1f нс на преобразование\n",
+           (t1 - t0) * 1e9 / N, (t2 - t1) * 1e9 / N);
+    return m_over ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+// RGB -> HSV на всех 16.7M 8-битных входах: ошибка возврата через
+// HSV -> RGB, дрейф при повторных циклах и скорость преобразования
+#include <stdio.h>
+#include <time.h>
+#include "color.h"
+
+#define TOP 255U
+#define MAX_ERROR 1
+
+static double seconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static void round_trip(uint8_t const in[3], uint8_t out[3]) {
+    color_hsv_t hsv;
+    uint16_t c[3];
+    color_rgb_to_hsv(in[0], in[1], in[2], &hsv);
+    color_hsv_to_rgb(hsv.h, hsv.s, hsv.v, TOP, &c[0], &c[1], &c[2]);
+    for (int i = 0; i < 3; i++) out[i] = (uint8_t)c[i];
+}
+
+int main(void) {
+    unsigned long count = 0, drift = 0, over = 0;
+    unsigned long long err_sum = 0;
+    int max_err = 0;
+
+    for (uint32_t x = 0; x < (1UL << 24); x++) {
+        uint8_t in[3] = { (uint8_t)(x >> 16), (uint8_t)(x >> 8), (uint8_t)x };
+        uint8_t once[3], twice[3];
+
+        round_trip(in, once);
+        int err = 0;
+        for (int i = 0; i < 3; i++) {
+            int d = (once[i] > in[i]) ? once[i] - in[i] : in[i] - once[i];
+            if (d > err) err = d;
+        }
+        if (err > max_err) max_err = err;
+        if (err > MAX_ERROR && over++ < 5) {
+            printf("  %u %u %u -> %u %u %u\n", in[0], in[1], in[2], once[0], once[1], once[2]);
+        }
+        err_sum += err;
+
+        // Второй цикл обязан вернуть то же: иначе цвет уползает
+        round_trip(once, twice);
+        if (once[0] != twice[0] || once[1] != twice[1] || once[2] != twice[2]) {
+            if (drift++ < 5) {
+                printf("  дрейф: %u %u %u -> %u %u %u\n", once[0], once[1], once[2], twice[0], twice[1], twice[2]);
+            }
+        }
+        count++;
+    }
+
+    volatile uint32_t sink = 0;
+    color_hsv_t hsv;
+    double t0 = seconds();
+    for (uint32_t x = 0; x < (1UL << 24); x++) {
+        color_rgb_to_hsv((uint8_t)(x >> 16), (uint8_t)(x >> 8), (uint8_t)x, &hsv);
+        sink += hsv.h + hsv.s + hsv.v;
+    }
+    double t1 = seconds();
+    (void)sink;
+
+    printf("RGB->HSV->RGB: %lu входов, ошибка наибольшая %d, средняя %.3f, сверх ±%d: %lu\n",
+           count, max_err, (double)err_sum / count, MAX_ERROR, over);
+    printf("  дрейф при повторе: %lu\n", drift);
+    printf("  RGB->HSV: %.1f млн/с\n", count / (t1 - t0) / 1e6);
+    return (over || drift) ? 1 : 0;
+}
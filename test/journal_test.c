@@ -0,0 +1,122 @@
+// Журнал настроек на имитации NVMC: стоимость записи и загрузки, затем
+// обрывы питания в случайной операции - в записи слова и посреди стирания.
+// После каждого обрыва журнал обязан отдать последнюю целую запись или ту,
+// что писалась в момент обрыва, и продолжить работу
+#include <stdio.h>
+#include <string.h>
+#include "journal.h"
+#include "nvm_sim.h"
+
+#define BASE 0x7B000U
+#define PAGES 2
+#define WORDS 6
+#define APPENDS 1000
+#define CUT_ROUNDS 20000
+
+static journal_t m_journal;
+// Меняются между setjmp и longjmp: только статические
+static uint32_t m_committed;    // значение последней законченной записи
+static uint32_t m_pending;      // значение записи, которая идёт сейчас
+static uint32_t m_next = 1;
+
+static void record(uint32_t value, uint32_t *p_words) {
+    for (uint32_t i = 0; i < WORDS; i++) p_words[i] = value * 0x9E3779B1U + i;
+}
+
+static bool mount(journal_t *p_journal) {
+    journal_init(p_journal, &nvm_sim, BASE, PAGES, NVM_SIM_PAGE, WORDS);
+    return journal_mount(p_journal);
+}
+
+// Последняя запись журнала: значение или 0, если журнал пуст; ~0 - мусор
+static bool same(uint32_t const *p_words, uint32_t value) {
+    uint32_t expect[WORDS];
+    record(value, expect);
+    return value != 0 && memcmp(p_words, expect, sizeof(expect)) == 0;
+}
+
+static uint32_t mounted_value(journal_t *p_journal) {
+    uint32_t words[WORDS];
+
+    if (!mount(p_journal)) return 0;
+    journal_read(p_journal, words);
+    if (same(words, m_committed)) return m_committed;
+    if (same(words, m_pending)) return m_pending;
+    return ~0U;
+}
+
+static int bench(void) {
+    uint32_t words[WORDS];
+
+    nvm_sim_reset(1);
+    mount(&m_journal);
+    for (uint32_t i = 1; i <= APPENDS; i++) {
+        record(i, words);
+        journal_append(&m_journal, words);
+    }
+    uint32_t writes = nvm_sim_stats.writes, erases = nvm_sim_stats.erases;
+
+    m_committed = m_pending = APPENDS;
+    int bad = mounted_value(&m_journal) != APPENDS;
+    printf("%d записей по %d слов: стираний %lu, слов записано %lu, чтений при загрузке %lu%s\n",
+           APPENDS, WORDS, (unsigned long)erases, (unsigned long)writes,
+           (unsigned long)m_journal.stats.mount_reads, bad ? " ОШИБКА" : "");
+    return bad;
+}
+
+static int power_cuts(void) {
+    static uint32_t bad;
+    uint32_t words[WORDS];
+
+    nvm_sim_reset(12345);
+    m_committed = m_pending = 0;
+
+    for (uint32_t round = 0; round < CUT_ROUNDS; round++) {
+        uint32_t value = mounted_value(&m_journal);
+        if (value == ~0U || (value == 0 && m_committed != 0)) {
+            if (bad++ < 5) {
+                printf("  обрыв %lu: загружено %s, ждали %lu или %lu\n", (unsigned long)round,
+                       value ? "чужое" : "пусто", (unsigned long)m_committed, (unsigned long)m_pending);
+            }
+            // Дальше проверять нечего: начинаем с чистой памяти
+            nvm_sim_reset(round + 1);
+            m_committed = m_pending = 0;
+            mount(&m_journal);
+            continue;
+        }
+        m_committed = m_pending = value;
+
+        // В половине случаев страница дописывается до конца без обрыва:
+        // тогда обрыв попадает в смену страницы и её стирание
+        if (nvm_sim_rand() % 2) {
+            while (m_journal.page >= 0 && m_journal.slot < m_journal.slots) {
+                m_pending = m_next++;
+                record(m_pending, words);
+                journal_append(&m_journal, words);
+                m_committed = m_pending;
+            }
+        }
+        nvm_sim_cut_after(1 + nvm_sim_rand() % (3 * (WORDS + 1) + 5));
+        if (setjmp(nvm_sim_cut_env) == 0) {
+            for (uint32_t i = 0; i < 3; i++) {
+                m_pending = m_next++;
+                record(m_pending, words);
+                journal_append(&m_journal, words);
+                m_committed = m_pending;
+            }
+            nvm_sim_cut_after(0);
+        }
+    }
+
+    printf("%d циклов, обрывов %lu (посреди стирания %lu): ошибок %lu, "
+           "перезаписей нестёртых слов %lu\n",
+           CUT_ROUNDS, (unsigned long)nvm_sim_stats.cuts, (unsigned long)nvm_sim_stats.erase_cuts,
+           (unsigned long)bad, (unsigned long)nvm_sim_stats.overwrites);
+    return bad != 0;
+}
+
+int main(void) {
+    int bad = bench();
+    bad |= power_cuts();
+    return bad;
+}
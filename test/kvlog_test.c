@@ -0,0 +1,126 @@
+// Журнал палитры на имитации NVMC: стираний и слов на 1000 правок против
+// перезаписи всей палитры на каждую правку, затем загрузка после обрыва
+// питания в случайной операции, в том числе посреди стирания при
+// уплотнении. Загрузка обязана дать палитру до оборванной правки или после
+#include <stdio.h>
+#include <string.h>
+#include "kvlog.h"
+#include "nvm_sim.h"
+
+#define BASE 0x79000U
+#define KEYS 10              // MAX_COLORS
+#define WORDS 5              // PALETTE_WORDS
+#define EDITS 1000
+#define CUT_ROUNDS 20000
+
+typedef struct {
+    bool     used[KEYS];
+    uint32_t words[KEYS][WORDS];
+} palette_t;
+
+static kvlog_t m_log;
+// Меняются между setjmp и longjmp: только статические
+static palette_t m_state;        // палитра в RAM, её отдаёт get
+static palette_t m_committed;    // палитра до правки, которая идёт сейчас
+static palette_t m_loaded;
+
+static bool get(void *p_context, uint16_t key, uint32_t *p_words) {
+    palette_t const *p = p_context;
+    if (!p->used[key]) return false;
+    memcpy(p_words, p->words[key], sizeof(p->words[key]));
+    return true;
+}
+
+static void apply(void *p_context, uint16_t key, uint32_t const *p_words) {
+    palette_t *p = p_context;
+    p->used[key] = (p_words != NULL);
+    if (p_words) memcpy(p->words[key], p_words, sizeof(p->words[key]));
+}
+
+static bool same(palette_t const *p_a, palette_t const *p_b) {
+    for (uint32_t k = 0; k < KEYS; k++) {
+        if (p_a->used[k] != p_b->used[k]) return false;
+        if (p_a->used[k] && memcmp(p_a->words[k], p_b->words[k], sizeof(p_a->words[k]))) return false;
+    }
+    return true;
+}
+
+static void mount(void) {
+    memset(&m_loaded, 0, sizeof(m_loaded));
+    kvlog_init(&m_log, &nvm_sim, BASE, NVM_SIM_PAGE, WORDS, KEYS, get, &m_state);
+    kvlog_mount(&m_log, apply, &m_loaded);
+}
+
+// Случайная правка: удаление занятого слота или новые данные
+static void edit(void) {
+    uint16_t key = (uint16_t)(nvm_sim_rand() % KEYS);
+
+    m_committed = m_state;
+    if (m_state.used[key] && nvm_sim_rand() % 3 == 0) {
+        m_state.used[key] = false;
+        kvlog_del(&m_log, key);
+    } else {
+        m_state.used[key] = true;
+        for (uint32_t i = 0; i < WORDS; i++) m_state.words[key][i] = nvm_sim_rand();
+        kvlog_put(&m_log, key, m_state.words[key]);
+    }
+    m_committed = m_state;
+}
+
+static int bench(void) {
+    nvm_sim_reset(7);
+    memset(&m_state, 0, sizeof(m_state));
+    mount();
+    for (uint32_t i = 0; i < EDITS; i++) edit();
+    uint32_t erases = nvm_sim_stats.erases, writes = nvm_sim_stats.writes;
+    uint32_t compactions = m_log.stats.compactions;
+
+    mount();
+    int bad = !same(&m_loaded, &m_state);
+    // Прежняя схема: стирание страницы и вся палитра с меткой на правку
+    printf("%d правок: стираний %lu, слов %lu, уплотнений %lu (перезапись целиком: %d стираний, %d слов)\n",
+           EDITS, (unsigned long)erases, (unsigned long)writes, (unsigned long)compactions,
+           EDITS, EDITS * (KEYS * (WORDS + 1) + 1));
+    printf("загрузка: чтений %lu, записей на странице %u из %u%s\n",
+           (unsigned long)m_log.stats.mount_reads, m_log.slot, m_log.slots, bad ? " ОШИБКА" : "");
+    return bad;
+}
+
+static int power_cuts(void) {
+    static uint32_t bad;
+
+    nvm_sim_reset(54321);
+    memset(&m_state, 0, sizeof(m_state));
+    m_committed = m_state;
+
+    for (uint32_t round = 0; round < CUT_ROUNDS; round++) {
+        mount();
+        if (!same(&m_loaded, &m_committed) && !same(&m_loaded, &m_state)) {
+            if (bad++ < 5) printf("  обрыв %lu: загружена чужая палитра\n", (unsigned long)round);
+        }
+        m_state = m_committed = m_loaded;
+
+        // В половине случаев страница дописывается почти до конца без
+        // обрыва, чтобы обрыв пришёлся на уплотнение и стирание
+        if (nvm_sim_rand() % 2) {
+            while (m_log.page >= 0 && m_log.slot + 1U < m_log.slots) edit();
+        }
+        nvm_sim_cut_after(1 + nvm_sim_rand() % (KEYS * (WORDS + 1) + 3 * (WORDS + 1) + 5));
+        if (setjmp(nvm_sim_cut_env) == 0) {
+            for (uint32_t i = 0; i < 3; i++) edit();
+            nvm_sim_cut_after(0);
+        }
+    }
+
+    printf("%d циклов, обрывов %lu (посреди стирания %lu): ошибок %lu, "
+           "перезаписей нестёртых слов %lu\n",
+           CUT_ROUNDS, (unsigned long)nvm_sim_stats.cuts, (unsigned long)nvm_sim_stats.erase_cuts,
+           (unsigned long)bad, (unsigned long)nvm_sim_stats.overwrites);
+    return bad != 0;
+}
+
+int main(void) {
+    int bad = bench();
+    bad |= power_cuts();
+    return bad;
+}
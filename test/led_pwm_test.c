@@ -0,0 +1,197 @@
+// Двойная буферизация led_pwm.c на имитации PWM: каждый запрос доходит до
+// вывода, отложенный применяется сразу после текущего переключения, период
+// никогда не смешивает каналы разных кадров, чёрный кадр останавливает PWM
+// без ожидания
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "led_pwm.h"
+#include "pwm_sim.h"
+
+#define DITHER_FRAMES (1U << LED_PWM_DITHER_BITS)
+#define LEVELS (LED_PWM_FIXTURES * 3)
+#define HISTORY 64
+
+// Экземпляры и каналы фикстур - как в m_channel_map
+static uint8_t const m_inst_used[] = { 0, 2 };
+
+typedef struct {
+    uint32_t total[2][PWM_CHANNELS];   // сумма отсчётов канала за цикл дизеринга
+} frame_t;
+
+static frame_t m_history[HISTORY];
+static uint32_t m_history_len;
+
+static uint32_t level_total(uint16_t level) {
+    return ((uint32_t)level * PWM_TOP_VALUE + (1U << (15 - LED_PWM_DITHER_BITS)))
+           >> (16 - LED_PWM_DITHER_BITS);
+}
+
+static void expect(uint16_t const *p_levels, frame_t *p_frame) {
+    memset(p_frame, 0, sizeof(*p_frame));
+    // Плата: RGB на каналах 1..3 PWM0
+    for (uint32_t c = 0; c < 3; c++) {
+        p_frame->total[0][c + 1] = level_total(p_levels[c]);
+    }
+    // Внешняя RGBW на PWM2: W забирает общую часть
+    uint16_t const *p_rgb = &p_levels[3];
+    uint16_t w = p_rgb[0] < p_rgb[1] ? p_rgb[0] : p_rgb[1];
+    if (p_rgb[2] < w) w = p_rgb[2];
+    for (uint32_t c = 0; c < 3; c++) {
+        p_frame->total[1][c] = level_total((uint16_t)(p_rgb[c] - w));
+    }
+    p_frame->total[1][3] = level_total(w);
+}
+
+// Остановленный экземпляр выводит чёрный
+static void played(uint32_t k, uint32_t total[PWM_CHANNELS]) {
+    uint16_t const *p_out = pwm_sim_output(m_inst_used[k]);
+    for (uint32_t c = 0; c < PWM_CHANNELS; c++) {
+        total[c] = 0;
+        if (p_out == NULL) continue;
+        for (uint32_t f = 0; f < DITHER_FRAMES; f++) {
+            total[c] += p_out[f * PWM_CHANNELS + c];
+        }
+    }
+}
+
+static bool shows(frame_t const *p_frame) {
+    for (uint32_t k = 0; k < 2; k++) {
+        uint32_t total[PWM_CHANNELS];
+        played(k, total);
+        if (memcmp(total, p_frame->total[k], sizeof(total)) != 0) return false;
+    }
+    return true;
+}
+
+// Каждый экземпляр в отдельности играет целиком один из недавних кадров
+static bool untorn(uint32_t k) {
+    uint32_t total[PWM_CHANNELS];
+    played(k, total);
+    for (uint32_t h = 0; h < m_history_len && h < HISTORY; h++) {
+        if (memcmp(total, m_history[h].total[k], sizeof(total)) == 0) return true;
+    }
+    return false;
+}
+
+static void pwm_write(uint16_t const *p_levels) {
+    expect(p_levels, &m_history[m_history_len++ % HISTORY]);
+    led_pwm_write(p_levels);
+}
+
+static void seq_end(uint32_t k) {
+    DWT->CYCCNT += 64000;
+    pwm_sim_seq_end(m_inst_used[k]);
+}
+
+// rounds последовательностей на всех экземплярах
+static void run(uint32_t rounds) {
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t k = 0; k < 2; k++) seq_end(k);
+    }
+}
+
+static void random_levels(uint16_t *p_levels) {
+    bool zero = (rand() & 15) == 0;
+    for (uint32_t c = 0; c < LEVELS; c++) {
+        p_levels[c] = zero ? 0 : (uint16_t)(rand() & 0xFFFF);
+    }
+    if (!zero && p_levels[0] == 0) p_levels[0] = 1;
+}
+
+int main(void) {
+    static uint16_t const a[LEVELS] = { 65535, 0, 0, 1000, 2000, 3000 };
+    static uint16_t const b[LEVELS] = { 0, 65535, 0, 40000, 40000, 100 };
+    static uint16_t const c[LEVELS] = { 0, 0, 65535, 7, 8, 9 };
+    static uint16_t const d[LEVELS] = { 100, 200, 300, 400, 500, 600 };
+    static uint16_t const e[LEVELS] = { 12345, 23456, 34567, 45678, 56789, 65535 };
+    static uint16_t const black[LEVELS];
+    led_pwm_stats_t st;
+    int bad = 0;
+
+    led_pwm_init();
+    expect(black, &m_history[m_history_len++]);
+
+    // Две записи подряд: каждая применяется за две последовательности
+    pwm_write(a);
+    run(2);
+    if (!shows(&m_history[1])) {
+        printf("первая запись не дошла до вывода\n");
+        bad = 1;
+    }
+    pwm_write(b);
+    run(2);
+    led_pwm_stats_get(&st);
+    if (!shows(&m_history[2]) || st.swaps != 2) {
+        printf("вторая запись не дошла до вывода (переключений %lu)\n", (unsigned long)st.swaps);
+        bad = 1;
+    }
+
+    // Запросы во время переключения: d откладывается, e заменяет его,
+    // после c сразу применяется e
+    pwm_write(c);
+    run(1);
+    pwm_write(d);
+    pwm_write(e);
+    run(2);
+    if (!shows(&m_history[3])) {
+        printf("переключение на c не завершилось\n");
+        bad = 1;
+    }
+    run(2);
+    led_pwm_stats_get(&st);
+    if (!shows(&m_history[5]) || st.swaps != 4 || st.deferred != 1 || st.coalesced != 1) {
+        printf("отложенная запись: переключений %lu, отложено %lu, объединено %lu\n",
+               (unsigned long)st.swaps, (unsigned long)st.deferred, (unsigned long)st.coalesced);
+        bad = 1;
+    }
+
+    // Чёрный кадр не ждёт конца периода: PWM встаёт по STOPPED. Запрос,
+    // пришедший до него, запускает вывод сразу после остановки
+    pwm_write(black);
+    bool waited = pwm_sim_output(0) == NULL;
+    run(1);
+    if (waited || !shows(&m_history[0]) || pwm_sim_output(0) != NULL) {
+        printf("остановка на чёрном: %s\n", waited ? "запись ждала останова" : "PWM не встал");
+        bad = 1;
+    }
+    pwm_write(a);
+    run(2);
+    pwm_write(black);
+    pwm_write(b);
+    run(1);
+    led_pwm_stats_get(&st);
+    if (!shows(&m_history[m_history_len - 1]) || st.suspends != 2 || st.resumes != 2) {
+        printf("запуск во время остановки: остановок %lu, запусков %lu\n",
+               (unsigned long)st.suspends, (unsigned long)st.resumes);
+        bad = 1;
+    }
+
+    // Случайные записи, в том числе чёрные, вперемешку с концами последовательностей
+    srand(1);
+    uint32_t torn = 0;
+    for (uint32_t step = 0; step < 200000; step++) {
+        if ((rand() & 3) == 0) {
+            uint16_t lv[LEVELS];
+            random_levels(lv);
+            pwm_write(lv);
+        } else {
+            uint32_t k = (uint32_t)rand() & 1;
+            seq_end(k);
+            if (!untorn(k)) torn++;
+        }
+    }
+    // Текущее переключение и отложенное за ним
+    run(4);
+    led_pwm_stats_get(&st);
+    if (torn != 0 || !shows(&m_history[(m_history_len - 1) % HISTORY])) {
+        printf("случайные записи: смешанных периодов %lu, последняя %s\n", (unsigned long)torn,
+               shows(&m_history[(m_history_len - 1) % HISTORY]) ? "показана" : "не показана");
+        bad = 1;
+    }
+
+    printf("переключений %lu, отложено %lu, объединено %lu, остановок %lu, запусков %lu%s\n",
+           (unsigned long)st.swaps, (unsigned long)st.deferred, (unsigned long)st.coalesced,
+           (unsigned long)st.suspends, (unsigned long)st.resumes, bad ? " ОШИБКА" : "");
+    return bad;
+}
@@ -0,0 +1,104 @@
+#include "nvm_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t m_mem[NVM_SIM_SIZE / sizeof(uint32_t)];
+static uint32_t m_cut;
+static uint32_t m_rand = 1;
+
+nvm_sim_stats_t nvm_sim_stats;
+jmp_buf nvm_sim_cut_env;
+
+uint32_t nvm_sim_rand(void) {
+    // xorshift32
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+// Случайная маска, доля единиц - от 1/64 до 7/8
+static uint32_t rand_mask(void) {
+    switch (nvm_sim_rand() % 4) {
+        case 0:  return nvm_sim_rand() & nvm_sim_rand() & nvm_sim_rand() & nvm_sim_rand()
+                        & nvm_sim_rand() & nvm_sim_rand();
+        case 1:  return nvm_sim_rand() & nvm_sim_rand() & nvm_sim_rand();
+        case 2:  return nvm_sim_rand();
+        default: return nvm_sim_rand() | nvm_sim_rand() | nvm_sim_rand();
+    }
+}
+
+static uint32_t *word(uint32_t addr) {
+    if (addr < NVM_SIM_BASE || addr >= NVM_SIM_BASE + NVM_SIM_SIZE || (addr & 3U)) {
+        fprintf(stderr, "nvm_sim: адрес 0x%08x вне flash\n", addr);
+        abort();
+    }
+    return &m_mem[(addr - NVM_SIM_BASE) / sizeof(uint32_t)];
+}
+
+// true - эта операция обрывается
+static bool cut_now(void) {
+    if (m_cut == 0) return false;
+    return --m_cut == 0;
+}
+
+static uint32_t sim_read(uint32_t addr) {
+    return *word(addr);
+}
+
+static void sim_write(uint32_t addr, uint32_t value) {
+    uint32_t *p = word(addr);
+
+    if (value & ~*p) nvm_sim_stats.overwrites++;
+    nvm_sim_stats.writes++;
+    if (cut_now()) {
+        // Сброшена только часть битов, которые запись сбрасывает
+        *p &= value | rand_mask();
+        nvm_sim_stats.cuts++;
+        longjmp(nvm_sim_cut_env, 1);
+    }
+    *p &= value;
+}
+
+static void sim_erase(uint32_t page_addr) {
+    uint32_t *p = word(page_addr);
+    uint32_t words = NVM_SIM_PAGE / sizeof(uint32_t);
+
+    if ((page_addr - NVM_SIM_BASE) % NVM_SIM_PAGE) {
+        fprintf(stderr, "nvm_sim: 0x%08x - не начало страницы\n", page_addr);
+        abort();
+    }
+    nvm_sim_stats.erases++;
+    if (cut_now()) {
+        uint32_t mask = rand_mask();
+        for (uint32_t i = 0; i < words; i++) {
+            // Биты поднимаются вразнобой, у слов - в разной степени
+            p[i] |= mask & rand_mask();
+        }
+        nvm_sim_stats.cuts++;
+        nvm_sim_stats.erase_cuts++;
+        longjmp(nvm_sim_cut_env, 1);
+    }
+    for (uint32_t i = 0; i < words; i++) {
+        p[i] = 0xFFFFFFFFU;
+    }
+}
+
+journal_nvm_t const nvm_sim = {
+    .read  = sim_read,
+    .write = sim_write,
+    .erase = sim_erase
+};
+
+void nvm_sim_reset(uint32_t seed) {
+    for (uint32_t i = 0; i < sizeof(m_mem) / sizeof(m_mem[0]); i++) {
+        m_mem[i] = 0xFFFFFFFFU;
+    }
+    m_cut = 0;
+    m_rand = seed ? seed : 1;
+    nvm_sim_stats = (nvm_sim_stats_t){ 0 };
+}
+
+void nvm_sim_cut_after(uint32_t ops) {
+    m_cut = ops;
+}
@@ -0,0 +1,41 @@
+#ifndef NVM_SIM_H
+#define NVM_SIM_H
+
+#include <setjmp.h>
+#include <stdint.h>
+#include "journal.h"
+
+// Имитация NVMC для проверок журналов на ПК: flash - массив слов, запись
+// только сбрасывает биты, стирание поднимает все биты страницы. Обрыв
+// питания на заданной операции оставляет её недоделанной и прыгает в
+// nvm_sim_cut_env:
+//  - у записи сброшена лишь часть нужных битов;
+//  - у стирания (на устройстве оно идёт долями ERASEPAGEPARTIAL) каждое
+//    слово поднято частично: метка может уцелеть, а номер в заголовке -
+//    вырасти
+#define NVM_SIM_BASE 0x78000U
+#define NVM_SIM_SIZE 0x8000U
+#define NVM_SIM_PAGE 4096U
+
+typedef struct {
+    uint32_t writes;
+    uint32_t erases;
+    uint32_t cuts;
+    uint32_t erase_cuts;     // из них посреди стирания
+    uint32_t overwrites;     // запись поднимала бы биты: слово не было стёрто
+} nvm_sim_stats_t;
+
+extern journal_nvm_t const nvm_sim;
+extern nvm_sim_stats_t nvm_sim_stats;
+extern jmp_buf nvm_sim_cut_env;
+
+// Вся память стёрта, счётчики и обрыв сброшены
+void nvm_sim_reset(uint32_t seed);
+
+// Обрыв на ops-й от текущей операции, 0 - без обрыва
+void nvm_sim_cut_after(uint32_t ops);
+
+// Детерминированный генератор для самих проверок
+uint32_t nvm_sim_rand(void);
+
+#endif
@@ -0,0 +1,123 @@
+#include "pwm_sim.h"
+
+static DWT_Type m_dwt;
+static CoreDebug_Type m_core_debug;
+static NRF_RTC_Type m_rtc2;
+
+DWT_Type *DWT = &m_dwt;
+CoreDebug_Type *CoreDebug = &m_core_debug;
+NRF_RTC_Type *NRF_RTC2 = &m_rtc2;
+
+NRF_PWM_Type pwm_sim_regs[4];
+
+static void slot_start(NRF_PWM_Type *p_reg, uint8_t slot) {
+    p_reg->slot = slot;
+    p_reg->p_play = p_reg->p_ptr[slot];
+}
+
+void pwm_sim_seq_end(uint32_t i) {
+    NRF_PWM_Type *p_reg = &pwm_sim_regs[i];
+    if (!p_reg->running) return;
+
+    // STOP без ожидания: останов в конце периода, затем STOPPED
+    if (p_reg->stopping) {
+        p_reg->running = false;
+        p_reg->stopping = false;
+        if (p_reg->handler) p_reg->handler(NRFX_PWM_EVT_STOPPED);
+        return;
+    }
+
+    uint8_t slot = p_reg->slot;
+    uint32_t int_mask = slot ? NRF_PWM_INT_SEQEND1_MASK : NRF_PWM_INT_SEQEND0_MASK;
+    uint32_t flag = slot ? NRFX_PWM_FLAG_SIGNAL_END_SEQ1 : NRFX_PWM_FLAG_SIGNAL_END_SEQ0;
+
+    // Следующий слот стартует сразу, обработчик застаёт его уже играющим
+    if (p_reg->loops == 0) {
+        slot_start(p_reg, p_reg->start_slot);
+    } else {
+        slot_start(p_reg, slot ^ 1);
+    }
+
+    if ((p_reg->inten & int_mask) && (p_reg->flags & flag) && p_reg->handler) {
+        p_reg->handler(slot ? NRFX_PWM_EVT_END_SEQ1 : NRFX_PWM_EVT_END_SEQ0);
+    }
+}
+
+uint16_t const *pwm_sim_output(uint32_t i) {
+    return pwm_sim_regs[i].running ? pwm_sim_regs[i].p_play : NULL;
+}
+
+void nrf_pwm_int_enable(NRF_PWM_Type *p_reg, uint32_t mask) {
+    p_reg->inten |= mask;
+}
+
+void nrf_pwm_int_disable(NRF_PWM_Type *p_reg, uint32_t mask) {
+    p_reg->inten &= ~mask;
+}
+
+void nrf_pwm_event_clear(NRF_PWM_Type *p_reg, nrf_pwm_event_t event) {
+    (void)p_reg;
+    (void)event;
+}
+
+void nrf_pwm_decoder_set(NRF_PWM_Type *p_reg, nrf_pwm_dec_load_t load, nrf_pwm_dec_step_t step) {
+    (void)p_reg;
+    (void)load;
+    (void)step;
+}
+
+ret_code_t nrfx_pwm_init(nrfx_pwm_t const *p_instance, nrfx_pwm_config_t const *p_config,
+                         nrfx_pwm_handler_t handler) {
+    (void)p_config;
+    p_instance->p_registers->handler = handler;
+    return NRF_SUCCESS;
+}
+
+// Как nrfx: LOOP = count / 2, нечётное число начинает с SEQ1, флаг LOOP
+// замыкает LOOPSDONE на слот старта
+uint32_t nrfx_pwm_simple_playback(nrfx_pwm_t const *p_instance, nrf_pwm_sequence_t const *p_sequence,
+                                  uint16_t playback_count, uint32_t flags) {
+    NRF_PWM_Type *p_reg = p_instance->p_registers;
+
+    p_reg->p_ptr[0] = p_sequence->values.p_raw;
+    p_reg->p_ptr[1] = p_sequence->values.p_raw;
+    p_reg->loops = (uint16_t)(playback_count / 2);
+    p_reg->start_slot = (uint8_t)(playback_count & 1);
+    p_reg->flags = flags;
+    p_reg->inten = 0;
+    if (flags & NRFX_PWM_FLAG_SIGNAL_END_SEQ0) p_reg->inten |= NRF_PWM_INT_SEQEND0_MASK;
+    if (flags & NRFX_PWM_FLAG_SIGNAL_END_SEQ1) p_reg->inten |= NRF_PWM_INT_SEQEND1_MASK;
+    p_reg->running = true;
+    p_reg->stopping = false;
+    slot_start(p_reg, p_reg->start_slot);
+    return 0;
+}
+
+// Как nrfx: стоявший экземпляр - сразу true, иначе STOP и ожидание по желанию
+bool nrfx_pwm_stop(nrfx_pwm_t const *p_instance, bool wait_until_stopped) {
+    NRF_PWM_Type *p_reg = p_instance->p_registers;
+
+    if (!p_reg->running) return true;
+    if (!wait_until_stopped) {
+        p_reg->stopping = true;
+        return false;
+    }
+    p_reg->running = false;
+    p_reg->stopping = false;
+    return true;
+}
+
+bool nrfx_pwm_is_stopped(nrfx_pwm_t const *p_instance) {
+    return !p_instance->p_registers->running;
+}
+
+void nrfx_pwm_sequence_values_update(nrfx_pwm_t const *p_instance, uint8_t seq_id,
+                                     nrf_pwm_values_t values) {
+    p_instance->p_registers->p_ptr[seq_id] = values.p_raw;
+}
+
+uint32_t nrfx_pwm_task_address_get(nrfx_pwm_t const *p_instance, nrf_pwm_task_t task) {
+    (void)p_instance;
+    (void)task;
+    return 0;
+}
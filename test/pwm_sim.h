@@ -0,0 +1,20 @@
+#ifndef PWM_SIM_H
+#define PWM_SIM_H
+
+#include <stdint.h>
+#include "nrfx_pwm.h"
+
+// Имитация PWM для проверки led_pwm.c на ПК. Как у nRF52: у экземпляра два
+// слота SEQ0/SEQ1, указатель слота читается при его старте, SEQENDn приходит
+// в обработчик только при включённом прерывании и флаге SIGNAL_END_SEQn.
+// Время идёт только в pwm_sim_seq_end(): текущий слот доиграл, дальше
+// следующий по LOOP и коротким связям LOOPSDONE -> SEQSTARTn. STOP без
+// ожидания тоже доходит только там: экземпляр встаёт и шлёт STOPPED
+
+// Слот, играющий на экземпляре i, доиграл до конца
+void pwm_sim_seq_end(uint32_t i);
+
+// Значения, которые экземпляр выводит сейчас, NULL - остановлен
+uint16_t const *pwm_sim_output(uint32_t i);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef APP_ERROR_H
+#define APP_ERROR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdk_errors.h"
+
+#define APP_ERROR_CHECK(err)                                             \
+    do {                                                                 \
+        ret_code_t e_ = (err);                                           \
+        if (e_ != NRF_SUCCESS) {                                         \
+            printf("%s:%d: ошибка %lu\n", __FILE__, __LINE__, (unsigned long)e_); \
+            abort();                                                     \
+        }                                                                \
+    } while (0)
+
+#endif
@@ -0,0 +1,10 @@
+// На ПК прерываний нет: обработчики PWM зовёт сама имитация
+#ifndef APP_UTIL_PLATFORM_H
+#define APP_UTIL_PLATFORM_H
+
+#include "nrf.h"
+
+#define CRITICAL_REGION_ENTER() {
+#define CRITICAL_REGION_EXIT()  }
+
+#endif
@@ -0,0 +1,31 @@
+// Минимум nrf.h для сборки модулей на ПК
+#ifndef NRF_H
+#define NRF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type *DWT;
+extern CoreDebug_Type *CoreDebug;
+
+#define CoreDebug_DEMCR_TRCENA_Msk 1U
+#define DWT_CTRL_CYCCNTENA_Msk     1U
+
+#define RTC_COUNTER_COUNTER_Msk 0xFFFFFFU
+
+typedef struct pwm_sim_s NRF_PWM_Type;
+typedef struct { uint32_t dummy; } NRF_RTC_Type;
+
+extern NRF_RTC_Type *NRF_RTC2;
+
+#endif
@@ -0,0 +1,46 @@
+// PWM на ПК: регистры - состояние имитации (nrfx_pwm.h, pwm_sim.c)
+#ifndef NRF_PWM_H
+#define NRF_PWM_H
+
+#include "nrf.h"
+
+typedef struct {
+    uint16_t channel_0;
+    uint16_t channel_1;
+    uint16_t channel_2;
+    uint16_t channel_3;
+} nrf_pwm_values_individual_t;
+
+typedef uint16_t nrf_pwm_values_common_t;
+
+typedef union {
+    nrf_pwm_values_common_t const *p_common;
+    nrf_pwm_values_individual_t const *p_individual;
+    uint16_t const *p_raw;
+} nrf_pwm_values_t;
+
+typedef struct {
+    nrf_pwm_values_t values;
+    uint16_t length;
+    uint32_t repeats;
+    uint32_t end_delay;
+} nrf_pwm_sequence_t;
+
+typedef enum { NRF_PWM_CLK_1MHz = 4 } nrf_pwm_clk_t;
+typedef enum { NRF_PWM_MODE_UP } nrf_pwm_mode_t;
+typedef enum { NRF_PWM_LOAD_COMMON, NRF_PWM_LOAD_INDIVIDUAL = 2 } nrf_pwm_dec_load_t;
+typedef enum { NRF_PWM_STEP_AUTO, NRF_PWM_STEP_TRIGGERED } nrf_pwm_dec_step_t;
+typedef enum { NRF_PWM_TASK_NEXTSTEP } nrf_pwm_task_t;
+typedef enum { NRF_PWM_EVENT_SEQEND0, NRF_PWM_EVENT_SEQEND1 } nrf_pwm_event_t;
+
+#define NRF_PWM_CHANNEL_COUNT 4
+
+#define NRF_PWM_INT_SEQEND0_MASK (1UL << 4)
+#define NRF_PWM_INT_SEQEND1_MASK (1UL << 5)
+
+void nrf_pwm_int_enable(NRF_PWM_Type *p_reg, uint32_t mask);
+void nrf_pwm_int_disable(NRF_PWM_Type *p_reg, uint32_t mask);
+void nrf_pwm_event_clear(NRF_PWM_Type *p_reg, nrf_pwm_event_t event);
+void nrf_pwm_decoder_set(NRF_PWM_Type *p_reg, nrf_pwm_dec_load_t load, nrf_pwm_dec_step_t step);
+
+#endif
@@ -0,0 +1,41 @@
+// RTC2 анимации: на ПК регистры не нужны, вызовы ничего не делают
+#ifndef NRF_RTC_H
+#define NRF_RTC_H
+
+#include "nrf.h"
+
+#define RTC_INPUT_FREQ 32768U
+
+typedef enum { NRF_RTC_TASK_START, NRF_RTC_TASK_STOP, NRF_RTC_TASK_CLEAR } nrf_rtc_task_t;
+typedef enum { NRF_RTC_EVENT_COMPARE_0 } nrf_rtc_event_t;
+
+#define NRF_RTC_INT_COMPARE0_MASK (1UL << 16)
+
+static inline void nrf_rtc_task_trigger(NRF_RTC_Type *p_reg, nrf_rtc_task_t task) {
+    (void)p_reg; (void)task;
+}
+static inline void nrf_rtc_prescaler_set(NRF_RTC_Type *p_reg, uint32_t val) {
+    (void)p_reg; (void)val;
+}
+static inline void nrf_rtc_cc_set(NRF_RTC_Type *p_reg, uint32_t ch, uint32_t val) {
+    (void)p_reg; (void)ch; (void)val;
+}
+static inline void nrf_rtc_event_clear(NRF_RTC_Type *p_reg, nrf_rtc_event_t event) {
+    (void)p_reg; (void)event;
+}
+static inline void nrf_rtc_event_enable(NRF_RTC_Type *p_reg, uint32_t mask) {
+    (void)p_reg; (void)mask;
+}
+static inline void nrf_rtc_event_disable(NRF_RTC_Type *p_reg, uint32_t mask) {
+    (void)p_reg; (void)mask;
+}
+static inline uint32_t nrf_rtc_event_address_get(NRF_RTC_Type const *p_reg, nrf_rtc_event_t event) {
+    (void)p_reg; (void)event;
+    return 0;
+}
+static inline uint32_t nrf_rtc_task_address_get(NRF_RTC_Type const *p_reg, nrf_rtc_task_t task) {
+    (void)p_reg; (void)task;
+    return 0;
+}
+
+#endif
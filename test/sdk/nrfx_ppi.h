@@ -0,0 +1,30 @@
+#ifndef NRFX_PPI_H
+#define NRFX_PPI_H
+
+#include "nrf.h"
+#include "sdk_errors.h"
+
+typedef uint32_t nrf_ppi_channel_t;
+
+static inline ret_code_t nrfx_ppi_channel_alloc(nrf_ppi_channel_t *p_channel) {
+    *p_channel = 0;
+    return NRF_SUCCESS;
+}
+static inline ret_code_t nrfx_ppi_channel_assign(nrf_ppi_channel_t ch, uint32_t eep, uint32_t tep) {
+    (void)ch; (void)eep; (void)tep;
+    return NRF_SUCCESS;
+}
+static inline ret_code_t nrfx_ppi_channel_fork_assign(nrf_ppi_channel_t ch, uint32_t fork_tep) {
+    (void)ch; (void)fork_tep;
+    return NRF_SUCCESS;
+}
+static inline ret_code_t nrfx_ppi_channel_enable(nrf_ppi_channel_t ch) {
+    (void)ch;
+    return NRF_SUCCESS;
+}
+static inline ret_code_t nrfx_ppi_channel_disable(nrf_ppi_channel_t ch) {
+    (void)ch;
+    return NRF_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,70 @@
+// Драйвер PWM на ПК: проигрывание моделирует ../pwm_sim.c
+#ifndef NRFX_PWM_H
+#define NRFX_PWM_H
+
+#include "nrf_pwm.h"
+#include "sdk_errors.h"
+
+typedef enum {
+    NRFX_PWM_EVT_FINISHED,
+    NRFX_PWM_EVT_END_SEQ0,
+    NRFX_PWM_EVT_END_SEQ1,
+    NRFX_PWM_EVT_STOPPED,
+} nrfx_pwm_evt_type_t;
+
+typedef void (*nrfx_pwm_handler_t)(nrfx_pwm_evt_type_t event_type);
+
+struct pwm_sim_s {
+    bool running;
+    bool stopping;                 // STOP дан, период ещё идёт
+    uint8_t slot;                  // играющий слот
+    uint8_t start_slot;            // слот, который перезапускает LOOPSDONE
+    uint16_t loops;                // LOOP: 0 - по кругу играет один start_slot
+    uint16_t const *p_ptr[2];      // SEQ[n].PTR
+    uint16_t const *p_play;        // что читает EasyDMA сейчас
+    uint32_t inten;
+    uint32_t flags;
+    nrfx_pwm_handler_t handler;
+};
+
+extern NRF_PWM_Type pwm_sim_regs[4];
+
+typedef struct {
+    NRF_PWM_Type *p_registers;
+    uint8_t drv_inst_idx;
+} nrfx_pwm_t;
+
+#define NRFX_PWM_INSTANCE(id) { .p_registers = &pwm_sim_regs[id], .drv_inst_idx = (id) }
+
+#define NRFX_PWM_PIN_NOT_USED 0xFF
+#define NRFX_PWM_PIN_INVERTED 0x80
+
+typedef struct {
+    uint8_t output_pins[NRF_PWM_CHANNEL_COUNT];
+    uint8_t irq_priority;
+    nrf_pwm_clk_t base_clock;
+    nrf_pwm_mode_t count_mode;
+    uint16_t top_value;
+    nrf_pwm_dec_load_t load_mode;
+    nrf_pwm_dec_step_t step_mode;
+} nrfx_pwm_config_t;
+
+#define NRFX_PWM_DEFAULT_CONFIG { .irq_priority = 6 }
+
+#define NRFX_PWM_FLAG_STOP            0x01
+#define NRFX_PWM_FLAG_LOOP            0x02
+#define NRFX_PWM_FLAG_SIGNAL_END_SEQ0 0x04
+#define NRFX_PWM_FLAG_SIGNAL_END_SEQ1 0x08
+#define NRFX_PWM_FLAG_NO_EVT_FINISHED 0x10
+
+ret_code_t nrfx_pwm_init(nrfx_pwm_t const *p_instance, nrfx_pwm_config_t const *p_config,
+                         nrfx_pwm_handler_t handler);
+uint32_t nrfx_pwm_simple_playback(nrfx_pwm_t const *p_instance, nrf_pwm_sequence_t const *p_sequence,
+                                  uint16_t playback_count, uint32_t flags);
+bool nrfx_pwm_stop(nrfx_pwm_t const *p_instance, bool wait_until_stopped);
+bool nrfx_pwm_is_stopped(nrfx_pwm_t const *p_instance);
+void nrfx_pwm_sequence_values_update(nrfx_pwm_t const *p_instance, uint8_t seq_id,
+                                     nrf_pwm_values_t values);
+uint32_t nrfx_pwm_task_address_get(nrfx_pwm_t const *p_instance, nrf_pwm_task_t task);
+
+#endif
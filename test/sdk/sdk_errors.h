@@ -0,0 +1,12 @@
+#ifndef SDK_ERRORS_H
+#define SDK_ERRORS_H
+
+#include <stdint.h>
+
+typedef uint32_t ret_code_t;
+
+#define NRF_SUCCESS             0
+#define NRF_ERROR_NO_MEM        4
+#define NRF_ERROR_INVALID_PARAM 7
+
+#endif
@@ -0,0 +1,94 @@
+// Кодер WS2812 и планировщик чанков: поток слотов, который выдал бы ШИМ,
+// декодируется обратно в байты; проверяются данные, хвост сброса и
+// чётность числа чанков
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ws2812.h"
+
+#define CHUNK_PIXELS 32
+#define MAX_PIXELS 1000
+
+static uint8_t m_fb[MAX_PIXELS * 4];
+static uint8_t m_decoded[MAX_PIXELS * 4];
+
+static int run(uint32_t pixels, uint32_t bpp) {
+    uint32_t bytes = pixels * bpp;
+    uint32_t chunk_bytes = CHUNK_PIXELS * bpp;
+    uint32_t chunk_slots = chunk_bytes * WS2812_SLOTS_PER_BYTE;
+    uint16_t *p_slots = malloc(chunk_slots * sizeof(uint16_t));
+    ws2812_sched_t sched;
+    uint32_t decoded = 0, bit = 0, tail = 0, played = 0;
+    int bad = 0;
+
+    for (uint32_t i = 0; i < bytes; i++) m_fb[i] = (uint8_t)(rand() >> 3);
+    memset(m_decoded, 0, sizeof(m_decoded));
+
+    uint16_t total = ws2812_sched_begin(&sched, m_fb, bytes, chunk_bytes);
+    if (total < 2 || (total & 1U)) {
+        printf("  %lu x %lu: чанков %u\n", (unsigned long)pixels, (unsigned long)bpp, total);
+        bad = 1;
+    }
+
+    while (ws2812_sched_next(&sched, p_slots)) {
+        played++;
+        for (uint32_t i = 0; i < chunk_slots; i++) {
+            uint16_t s = p_slots[i];
+            if (s == WS2812_SLOT_LOW) {
+                tail++;
+                continue;
+            }
+            // Бит после начала сброса ломает кадр: лента уже защёлкнула данные
+            if (tail != 0 || (s != WS2812_SLOT_0 && s != WS2812_SLOT_1) || decoded >= bytes) {
+                if (!bad) printf("  %lu x %lu: слот %04x в позиции %lu\n", (unsigned long)pixels,
+                                 (unsigned long)bpp, s, (unsigned long)(played - 1) * chunk_slots + i);
+                bad = 1;
+                continue;
+            }
+            m_decoded[decoded] = (uint8_t)((m_decoded[decoded] << 1) | (s == WS2812_SLOT_1));
+            if (++bit == 8) {
+                bit = 0;
+                decoded++;
+            }
+        }
+    }
+
+    if (played != total) {
+        printf("  выдано %lu чанков из %u\n", (unsigned long)played, total);
+        bad = 1;
+    }
+    if (decoded != bytes || bit != 0 || memcmp(m_decoded, m_fb, bytes) != 0) {
+        printf("  %lu x %lu: данные не совпали (%lu байт из %lu)\n", (unsigned long)pixels,
+               (unsigned long)bpp, (unsigned long)decoded, (unsigned long)bytes);
+        bad = 1;
+    }
+    if (tail < WS2812_RESET_SLOTS) {
+        printf("  %lu x %lu: сброс %lu слотов\n", (unsigned long)pixels, (unsigned long)bpp,
+               (unsigned long)tail);
+        bad = 1;
+    }
+    printf("%5lu x %lu: чанков %3u, сброс %4lu слотов (%.0f мкс), кадр %.2f мс%s\n",
+           (unsigned long)pixels, (unsigned long)bpp, total, (unsigned long)tail,
+           tail * 1.25, total * chunk_slots * 1.25 / 1000.0, bad ? " ОШИБКА" : "");
+    free(p_slots);
+    return bad;
+}
+
+int main(void) {
+    static uint32_t const pixels[] = { 1, 32, 33, 60, 300, 1000 };
+    int bad = 0;
+
+    // Длительности высокого уровня в окнах даташита WS2812B: 0.4/0.8 мкс ± 150 нс
+    double t0h = (WS2812_SLOT_0 & 0x7FFF) / 16.0, t1h = (WS2812_SLOT_1 & 0x7FFF) / 16.0;
+    if (t0h < 0.25 || t0h > 0.55 || t1h < 0.65 || t1h > 0.95) {
+        printf("T0H %.3f мкс, T1H %.3f мкс вне допуска\n", t0h, t1h);
+        bad = 1;
+    }
+
+    for (uint32_t bpp = 3; bpp <= 4; bpp++) {
+        for (size_t i = 0; i < sizeof(pixels) / sizeof(pixels[0]); i++) {
+            bad |= run(pixels[i], bpp);
+        }
+    }
+    return bad;
+}
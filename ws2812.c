@@ -0,0 +1,46 @@
+#include "ws2812.h"
+
+void ws2812_encode(uint8_t const *p_bytes, uint32_t count, uint16_t *p_slots) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t b = p_bytes[i];
+        for (int32_t bit = 7; bit >= 0; bit--) {
+            *p_slots++ = (uint16_t)(WS2812_SLOT_0 +
+                                    ((b >> bit) & 1U) * (WS2812_SLOT_1 - WS2812_SLOT_0));
+        }
+    }
+}
+
+uint16_t ws2812_sched_begin(ws2812_sched_t *p_sched, uint8_t const *p_fb,
+                            uint32_t bytes, uint32_t chunk_bytes) {
+    uint32_t chunk_slots = chunk_bytes * WS2812_SLOTS_PER_BYTE;
+    uint32_t data = (bytes + chunk_bytes - 1) / chunk_bytes;
+    uint32_t reset = (WS2812_RESET_SLOTS + chunk_slots - 1) / chunk_slots;
+    uint32_t total = (data + reset + 1) & ~1U;
+
+    p_sched->p_fb = p_fb;
+    p_sched->bytes = bytes;
+    p_sched->pos = 0;
+    p_sched->chunk_bytes = chunk_bytes;
+    p_sched->chunks_left = (uint16_t)total;
+    return (uint16_t)total;
+}
+
+bool ws2812_sched_next(ws2812_sched_t *p_sched, uint16_t *p_slots) {
+    uint32_t chunk_slots = p_sched->chunk_bytes * WS2812_SLOTS_PER_BYTE;
+    uint32_t n = 0;
+
+    if (p_sched->chunks_left == 0) return false;
+    p_sched->chunks_left--;
+
+    if (p_sched->pos < p_sched->bytes) {
+        n = p_sched->bytes - p_sched->pos;
+        if (n > p_sched->chunk_bytes) n = p_sched->chunk_bytes;
+        ws2812_encode(&p_sched->p_fb[p_sched->pos], n, p_slots);
+        p_sched->pos += n;
+    }
+
+    for (uint32_t i = n * WS2812_SLOTS_PER_BYTE; i < chunk_slots; i++) {
+        p_slots[i] = WS2812_SLOT_LOW;
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef WS2812_H
+#define WS2812_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Кодирование WS2812/SK6812 в слоты ШИМ (NRF_PWM_LOAD_COMMON): один бит -
+// один период 16 МГц / 20 = 1.25 мкс. Бит 15 слота - полярность: высокий
+// уровень идёт первым и длится значение слота. Модуль не зависит от SDK
+#define WS2812_PWM_TOP   20
+#define WS2812_SLOT_0    (0x8000 | 6)    // T0H 0.375 мкс
+#define WS2812_SLOT_1    (0x8000 | 13)   // T1H 0.81 мкс
+#define WS2812_SLOT_LOW  (0x8000 | 0)    // весь период низкий (сброс)
+
+#define WS2812_SLOTS_PER_BYTE 8
+// Пауза сброса: >= 280 мкс для WS2812B/SK6812 новых ревизий
+#define WS2812_RESET_SLOTS 224
+
+// count байт (в порядке передачи) -> count * 8 слотов, старший бит первым
+void ws2812_encode(uint8_t const * p_bytes, uint32_t count, uint16_t * p_slots);
+
+// Планировщик чанков: кадр выдаётся кусками по chunk_bytes байт в два
+// буфера SEQ0/SEQ1 попеременно, после данных - хвост сброса. Число чанков
+// чётное, чтобы кадр укладывался в целое число циклов SEQ0+SEQ1
+typedef struct {
+    uint8_t const * p_fb;
+    uint32_t bytes;        // байт в кадре
+    uint32_t pos;          // следующий байт для кодирования
+    uint32_t chunk_bytes;
+    uint16_t chunks_left;  // чанков до конца кадра, включая сброс
+} ws2812_sched_t;
+
+// Возвращает общее число чанков кадра (чётное, >= 2)
+uint16_t ws2812_sched_begin(ws2812_sched_t * p_sched, uint8_t const * p_fb,
+                            uint32_t bytes, uint32_t chunk_bytes);
+
+// Заполняет очередной чанк (chunk_bytes * 8 слотов). Хвост последнего чанка
+// данных и чанки сброса заполняются низким уровнем. false - кадр уже выдан
+bool ws2812_sched_next(ws2812_sched_t * p_sched, uint16_t * p_slots);
+
+#endif